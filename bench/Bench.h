@@ -0,0 +1,76 @@
+/*******************************************************************************************
+*
+*   Minimal timing helpers for the benchmarks.
+*
+*   The benchmarks are headless (no window is opened), so they only measure the logic side of things, such as pushing
+*   commands to the queues.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <stdio.h>
+
+namespace Bench
+{
+    /*!
+     * Something to write results to, so the compiler can't optimize away the work being measured
+     */
+    inline volatile uint64_t Sink = 0;
+
+    /*!
+     * Calls `func` `runs` times, and returns the best time per operation, in nanoseconds.
+     * `func` is expected to do `opsPerRun` operations each time. The best run is used, since it's the one least affected
+     * by anything else running on the machine.
+     */
+    template<typename F>
+    double Measure(int runs, int opsPerRun, F&& func)
+    {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < runs; i++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            func();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+            best = std::min(best, ns / opsPerRun);
+        }
+        return best;
+    }
+
+    /*!
+     * Same as Measure, but calls `prepare` before each run, outside of the timed region.
+     */
+    template<typename P, typename F>
+    double Measure(int runs, int opsPerRun, P&& prepare, F&& func)
+    {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < runs; i++)
+        {
+            prepare();
+            auto start = std::chrono::high_resolution_clock::now();
+            func();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+            best = std::min(best, ns / opsPerRun);
+        }
+        return best;
+    }
+
+    inline void Report(const char* name, double nsPerOp)
+    {
+        printf("%-56s %8.1f ns/op\n", name, nsPerOp);
+    }
+
+} // namespace Bench
+
+// Each group of benchmarks, called by BenchMain.cpp
+void RunCommandQueueBenchmarks();
+void RunTextBenchmarks();
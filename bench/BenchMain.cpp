@@ -0,0 +1,21 @@
+/*******************************************************************************************
+*
+*   Benchmarks for the logic side of the render queue.
+*
+*   Build the Benchmarks project in Release, and run it from the command line.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "Bench.h"
+
+int main()
+{
+    RunCommandQueueBenchmarks();
+    RunTextBenchmarks();
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************************
+*
+*   Benchmarks for pushing commands to a CommandQueue.
+*
+*   CommandQueue doesn't depend on raylib, so these measure the queue on its own.
+*   The allocators are compared with the same command mix, so how they handle queues growing and shrinking is all that
+*   differs.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "Bench.h"
+#include "CommandQueue.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Queue = CommandQueue<void()>;
+
+    constexpr int Runs = 200;
+    constexpr int CmdsPerRun = 10000;
+
+    /*!
+     * Pushes `CmdsPerRun` commands with `push(queue, index)`, and clears the queue, as a frame would.
+     * The queue is reserved upfront, so growing doesn't affect the results.
+     */
+    template<typename F>
+    double MeasurePushes(F&& push)
+    {
+        Queue q;
+        q.Reserve(4 * 1024 * 1024);
+
+        return Bench::Measure(Runs, CmdsPerRun, [&]()
+        {
+            for (int i = 0; i < CmdsPerRun; i++)
+            {
+                push(q, i);
+            }
+            Bench::Sink = Bench::Sink + q.GetUsedCapacity();
+            q.Clear();
+        });
+    }
+
+    /*!
+     * Runs a frame's worth of queues through `allocator`, and returns the best time per command.
+     * Like secondaries, the queues are created empty each run, and share a budget. Most frames push a few commands, but
+     * every `BurstInterval` frames each queue gets a burst, so the queues grow, are cleared, and shrink back afterwards.
+     */
+    double MeasureAllocator(QueueAllocator& allocator)
+    {
+        constexpr int AllocatorRuns = 50;
+        constexpr int NumQueues = 8;
+        constexpr int FramesPerRun = 64;
+        constexpr int BurstInterval = 16;
+        constexpr int SmallCmds = 256;
+        constexpr int BurstCmds = 16384;
+        constexpr int CmdsPerQueue = (FramesPerRun / BurstInterval) * BurstCmds + (FramesPerRun - FramesPerRun / BurstInterval) * SmallCmds;
+
+        // Follows the small frames, so the queues shrink a few frames after each burst
+        Queue::SizingPolicy policy;
+        policy.Percentile = 0.5f;
+        policy.ShrinkAfterFrames = 4;
+
+        CommandQueueBudget budget(64 * 1024 * 1024);
+        std::vector<std::unique_ptr<Queue>> queues;
+        queues.reserve(NumQueues);
+
+        return Bench::Measure(AllocatorRuns, NumQueues * CmdsPerQueue, [&]()
+        {
+            for (int i = 0; i < NumQueues; i++)
+            {
+                queues.push_back(std::make_unique<Queue>(0, QueueAllocatorRef(&allocator)));
+                queues.back()->SetSizingPolicy(policy);
+                queues.back()->SetBudget(&budget);
+            }
+
+            for (int frame = 0; frame < FramesPerRun; frame++)
+            {
+                const int numCmds = (frame % BurstInterval) == 0 ? BurstCmds : SmallCmds;
+                for (std::unique_ptr<Queue>& q : queues)
+                {
+                    for (int i = 0; i < numCmds; i++)
+                    {
+                        q->Push([i, f = static_cast<float>(i)](Queue&)
+                        {
+                            Bench::Sink = Bench::Sink + static_cast<uint64_t>(i) + static_cast<uint64_t>(f);
+                        });
+                    }
+                    Bench::Sink = Bench::Sink + q->GetUsedCapacity();
+                    q->Clear();
+                }
+            }
+
+            queues.clear();
+        });
+    }
+
+} // namespace
+
+void RunCommandQueueBenchmarks()
+{
+    // The common case, which PushNonTrivial shouldn't have made any slower
+    Bench::Report("Push (trivial)", MeasurePushes([](Queue& q, int i)
+    {
+        q.Push([i, f = static_cast<float>(i)](Queue&)
+        {
+            Bench::Sink = Bench::Sink + static_cast<uint64_t>(i) + static_cast<uint64_t>(f);
+        });
+    }));
+
+    // A trivial command through PushNonTrivial doesn't need the side list, so it should cost the same as Push
+    Bench::Report("PushNonTrivial (trivial)", MeasurePushes([](Queue& q, int i)
+    {
+        q.PushNonTrivial([i, f = static_cast<float>(i)](Queue&)
+        {
+            Bench::Sink = Bench::Sink + static_cast<uint64_t>(i) + static_cast<uint64_t>(f);
+        });
+    }));
+
+    // Short enough for the small string optimization, so this measures the side list and not the heap
+    Bench::Report("PushNonTrivial (std::string)", MeasurePushes([](Queue& q, int)
+    {
+        q.PushNonTrivial([str = std::string("label")](Queue&)
+        {
+            Bench::Sink = Bench::Sink + str.size();
+        });
+    }));
+
+    SystemQueueAllocator systemAllocator;
+    Bench::Report("Allocator mix (SystemQueueAllocator)", MeasureAllocator(systemAllocator));
+
+    PagePoolQueueAllocator pagePool;
+    Bench::Report("Allocator mix (PagePoolQueueAllocator)", MeasureAllocator(pagePool));
+
+    VirtualMemoryQueueAllocator virtualMemory(64 * 1024 * 1024);
+    Bench::Report("Allocator mix (VirtualMemoryQueueAllocator)", MeasureAllocator(virtualMemory));
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************************
+*
+*   Benchmarks for queuing text.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "Bench.h"
+#include "RenderQueue.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr int Runs = 200;
+    constexpr int TextsPerRun = 1000;
+
+    /*!
+     * Records `TextsPerRun` texts into a block with `drawText(index)`, and returns the best time per text.
+     * Blocks are used since they record without a render thread consuming the queues. The same block is reused, reserved
+     * upfront and cleared outside of the timed region, so only queuing the text is measured.
+     */
+    template<typename F>
+    double MeasureTexts(F&& drawText)
+    {
+        RenderCmdBlock block;
+        block.Reserve(4 * 1024 * 1024);
+
+        return Bench::Measure(Runs, TextsPerRun, [&block]() { block.Clear(); }, [&]()
+        {
+            RenderQueue::Record(block, [&]()
+            {
+                for (int i = 0; i < TextsPerRun; i++)
+                {
+                    drawText(i);
+                }
+            });
+        });
+    }
+
+    /*!
+     * A font with glyph data for printable ASCII, but no texture, so the layout cache can be used without a window.
+     */
+    struct BenchFont
+    {
+        BenchFont()
+        {
+            for (int c = 32; c < 127; c++)
+            {
+                const int index = c - 32;
+                Recs.push_back(Rectangle{static_cast<float>(index % 16) * 8.0f, static_cast<float>(index / 16) * 10.0f, 6.0f, 10.0f});
+                Glyphs.push_back(GlyphInfo{c, 0, 0, 7, Image{}});
+            }
+
+            Font.baseSize = 10;
+            Font.glyphCount = static_cast<int>(Glyphs.size());
+            Font.glyphPadding = 0;
+            Font.texture.width = 128;
+            Font.texture.height = 64;
+            Font.recs = Recs.data();
+            Font.glyphs = Glyphs.data();
+        }
+
+        std::vector<Rectangle> Recs;
+        std::vector<GlyphInfo> Glyphs;
+        ::Font Font = {};
+    };
+
+} // namespace
+
+void RunTextBenchmarks()
+{
+    RenderQueue renderQueue;
+    BenchFont font;
+
+    // Static strings, as a HUD or help text would use
+    constexpr int NumLabels = 16;
+    std::vector<std::string> labels;
+    for (int i = 0; i < NumLabels; i++)
+    {
+        labels.push_back(TextFormat("Label number %d, drawn every frame", i));
+    }
+
+    // Copies the string into the queue
+    Bench::Report("DrawText(std::string_view)", MeasureTexts([&labels](int i)
+    {
+        RenderQueue::DrawText(labels[i % NumLabels], 0, 0, 20, RED);
+    }));
+
+    // Only the id is queued, since no font is registered yet
+    std::vector<StringId> ids;
+    for (const std::string& label : labels)
+    {
+        ids.push_back(RenderQueue::Intern(label));
+    }
+    Bench::Report("DrawText(StringId)", MeasureTexts([&ids](int i)
+    {
+        RenderQueue::DrawText(ids[i % NumLabels], 0, 0, 20, RED);
+    }));
+
+    // Queues the cached glyph quads. After the first run, every call is a cache hit.
+    const uint32_t fontId = renderQueue.AddFont(font.Font);
+    Bench::Report("DrawText(StringId), cached layout", MeasureTexts([&ids, fontId](int i)
+    {
+        RenderQueue::DrawText(ids[i % NumLabels], 0, 0, 20, RED, fontId);
+    }));
+
+    // Formats into a temporary buffer, and then copies it into the queue
+    Bench::Report("DrawText(TextFormat(...))", MeasureTexts([](int i)
+    {
+        RenderQueue::DrawText(TextFormat("Frame %d: %.2f ms", i, static_cast<double>(i) * 0.01), 0, 0, 20, RED);
+    }));
+
+    // Formats directly into the queue
+    Bench::Report("DrawTextF(...)", MeasureTexts([](int i)
+    {
+        RenderQueue::DrawTextF(0, 0, 20, RED, "Frame {}: {:.2f} ms", i, static_cast<double>(i) * 0.01);
+    }));
+}
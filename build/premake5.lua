@@ -207,6 +207,49 @@ if (downloadRaylib) then
         filter{}
         
 
+    -- Headless benchmarks for the logic side of the render queue. Uses the same sources as the sample, except main.cpp.
+    project "Benchmarks"
+        kind "ConsoleApp"
+        location "build_files/"
+        targetdir "../bin/%{cfg.buildcfg}"
+
+        files {"../bench/**.cpp", "../bench/**.h", "../src/**.cpp", "../include/**.h"}
+        removefiles {"../src/main.cpp"}
+
+        includedirs { "../src" }
+        includedirs { "../include" }
+        includedirs { "../bench" }
+
+        links {"raylib"}
+
+        cdialect "C17"
+        cppdialect "C++20"
+
+        includedirs {raylib_dir .. "/src" }
+        includedirs {raylib_dir .."/src/external" }
+        includedirs { raylib_dir .."/src/external/glfw/include" }
+        platform_defines()
+
+        filter "action:vs*"
+            defines{"_WINSOCK_DEPRECATED_NO_WARNINGS", "_CRT_SECURE_NO_WARNINGS"}
+            dependson {"raylib"}
+            links {"raylib.lib"}
+            characterset ("Unicode")
+            buildoptions { "/Zc:__cplusplus" }
+
+        filter "system:windows"
+            defines{"_WIN32"}
+            links {"winmm", "gdi32", "opengl32"}
+            libdirs {"../bin/%{cfg.buildcfg}"}
+
+        filter "system:linux"
+            links {"pthread", "m", "dl", "rt", "X11"}
+
+        filter "system:macosx"
+            links {"OpenGL.framework", "Cocoa.framework", "IOKit.framework", "CoreFoundation.framework", "CoreAudio.framework", "CoreVideo.framework", "AudioToolbox.framework"}
+
+        filter{}
+
     project "raylib"
         kind "StaticLib"
     
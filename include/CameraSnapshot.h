@@ -0,0 +1,45 @@
+/*******************************************************************************************
+*
+*   Immutable snapshot of a 3D camera, for one frame.
+*
+*   The logic side owns the camera, and publishes a snapshot per frame with everything derived
+*   from it already computed (matrices and frustum). Culling, LOD and sorting on the logic side
+*   can then use exactly the same camera the render thread will render with.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "Frustum.h"
+#include "raylib.h"
+
+struct CameraSnapshot
+{
+    Camera3D Camera = {};
+
+    // Aspect ratio (width / height) of the viewport the projection was built for
+    float Aspect = 1.0f;
+
+    Matrix View = {};
+    Matrix Projection = {};
+    // View * Projection, as in raymath's MatrixMultiply(View, Projection)
+    Matrix ViewProjection = {};
+
+    Frustum ViewFrustum = {};
+
+    /*!
+     * Builds the snapshot. Same projection as raylib's BeginMode3D, which uses rlgl's default cull distances.
+     */
+    static CameraSnapshot Make(const Camera3D& camera, float aspect);
+
+    /*!
+     * Render thread only.
+     * Same as BeginMode3D, but loads the snapshot's matrices instead of computing them again. Use EndMode3D to finish.
+     */
+    void Begin() const;
+};
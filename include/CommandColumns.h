@@ -0,0 +1,130 @@
+/*******************************************************************************************
+*
+*   Struct-of-arrays storage for hot command types.
+*
+*   Instead of every command capturing its own copy of the fields (interleaved in the queue), each field is appended to
+*   its own contiguous array, and the queue only holds a command per run of rows (see CommandQueue::PushRow). The
+*   render side can then stream each field on its own (e.g all positions, then all colors), which is friendlier to
+*   the caches and to SIMD.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "QueueAllocator.h"
+
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace details
+{
+    /*!
+     * std allocator that aligns the arrays to MaxAlignment, so the columns can be read with aligned SIMD loads
+     */
+    template<typename T>
+    struct ColumnAllocator
+    {
+        using value_type = T;
+
+        ColumnAllocator() = default;
+        template<typename U>
+        ColumnAllocator(const ColumnAllocator<U>&)
+        {
+        }
+
+        T* allocate(std::size_t n)
+        {
+            // std containers expect allocation failures to throw
+            T* ptr = static_cast<T*>(AlignedAlloc(n * sizeof(T)));
+            if (!ptr)
+            {
+                throw std::bad_alloc();
+            }
+            return ptr;
+        }
+
+        void deallocate(T* ptr, std::size_t)
+        {
+            AlignedFree(ptr);
+        }
+
+        template<typename U>
+        bool operator==(const ColumnAllocator<U>&) const
+        {
+            return true;
+        }
+    };
+
+} // namespace details
+
+/*!
+ * One contiguous array per field.
+ * Commands that use this derive from it, and declare
+ * `static void CallRange(Queue& q, const Derived& columns, uint32_t begin, uint32_t count, Args... args)`, which
+ * CommandQueue::PushRow's commands call to run rows [begin, begin+count).
+ */
+template<typename... Ts>
+class CommandColumns
+{
+  public:
+    static_assert((std::is_trivially_copyable_v<Ts> && ...));
+
+    template<size_t I>
+    using ColumnType = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    uint32_t GetSize() const
+    {
+        return Size;
+    }
+
+    void Append(const Ts&... values)
+    {
+        std::apply([&](auto&... columns)
+        {
+            (columns.push_back(values), ...);
+        }, Columns);
+        Size++;
+    }
+
+    /*!
+     * Returns a pointer to the start of the column I
+     */
+    template<size_t I>
+    const ColumnType<I>* Get() const
+    {
+        return std::get<I>(Columns).data();
+    }
+
+    /*!
+     * Removes all rows, keeping the memory
+     */
+    void Clear()
+    {
+        std::apply([](auto&... columns)
+        {
+            (columns.clear(), ...);
+        }, Columns);
+        Size = 0;
+    }
+
+    /*!
+     * Bytes used by the rows
+     */
+    size_t GetUsedBytes() const
+    {
+        return static_cast<size_t>(Size) * (sizeof(Ts) + ...);
+    }
+
+  private:
+    std::tuple<std::vector<Ts, details::ColumnAllocator<Ts>>...> Columns;
+    uint32_t Size = 0;
+};
@@ -0,0 +1,1186 @@
+/*******************************************************************************************
+*
+*   This data container allows adding stateful lambdas for later execution, without
+*   allocating memory (other than the big memory block to store everything).
+*   It doesn't depend on raylib, so it can be used for any kind of deferred calls (e.g audio commands, physics events,
+*   cross-thread tasks). RenderCmdQueue is the instantiation used for rendering.
+*
+*   It allows the following:
+*   - Stateful lambdas can be pushed
+*   - Capacity grows as required, and is sized from a percentile of the usage in the last frames. It only shrinks
+*     after usage stays low for a while (see SizingPolicy), so a single spike doesn't pin memory forever.
+*   - OOB (out of band) data can be pushed for things that the lambda needs to access, but
+*     for whatever reason is not feasible to add to the capture list (e.g std::string) due
+*     to the limitations below.
+*
+*   - Commands and OOB data are placed at their type's alignment, up to MaxAlignment (64 bytes), so payloads with
+*     SIMD types or cache line aligned blocks can be used directly.
+*   - Commands can optionally be tracked per type, so queues where the order across types doesn't matter can run each
+*     type's commands together (see CallAllGrouped).
+*   - The memory comes from a QueueAllocator, which can be set per queue.
+*   - Memory can be bounded, per queue and/or shared by several queues (see CommandQueueBudget).
+*     Once a queue can't grow, pushes fail until the queue is cleared.
+*
+*   It is fast, but it has a few limitations:
+*   - Captured variables need to be trivially copyable, since things are copied around
+*     simply with memcpy. Commands that can't be (e.g capturing a std::string) can be pushed with
+*     PushNonTrivial, which keeps a list of them to move and destroy them properly.
+*   - Due to the intended use, it is not possible to remove single elements. Once the queue
+*     is processed and cleared in one go.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+#include <limits>
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <iterator>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string_view>
+#include <utility>
+
+#include "QueueAllocator.h"
+
+#if defined(_MSVC_LANG)
+        __pragma(warning(push))
+        __pragma(warning(disable: 5204))  /* 'type-name': class has virtual functions, but its trivial destructor is not virtual; instances of objects derived from this class may not be destructed correctly */
+#endif
+
+namespace details
+{
+    inline std::size_t NextPow2(std::size_t n) noexcept
+    {
+        std::size_t result = 1;
+        while (result <= n)
+        {
+            result *= 2;
+        }
+        return result;
+    }
+
+    inline std::size_t RoundPow2(std::size_t n) noexcept
+    {
+        if ((n == 0) || (n & (n - 1)))
+            return NextPow2(n);
+        return n;
+    }
+
+} // namespace details
+
+
+/*!
+ * Byte budget shared by several queues (e.g all the queues of a frame). Queues acquire from it when they grow, and give
+ * the memory back when destroyed.
+ * Thread safe, so the queues sharing it can be used from different threads.
+ */
+class CommandQueueBudget
+{
+  public:
+    /*!
+     * \param maxBytes
+     *  Maximum total capacity. 0 means no limit, in which case the budget just keeps track of the memory used.
+     */
+    explicit CommandQueueBudget(size_t maxBytes = 0)
+        : MaxBytes(maxBytes)
+    {
+    }
+
+    void SetMaxBytes(size_t maxBytes)
+    {
+        MaxBytes = maxBytes;
+    }
+
+    bool TryAcquire(size_t bytes)
+    {
+        size_t used = Used.load(std::memory_order_relaxed);
+        do
+        {
+            if (MaxBytes && (used + bytes > MaxBytes))
+            {
+                return false;
+            }
+        } while (!Used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+
+        return true;
+    }
+
+    // Accounts for memory that is already in use, without checking the limit
+    void ForceAcquire(size_t bytes)
+    {
+        Used.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void Release(size_t bytes)
+    {
+        Used.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    bool IsBounded() const
+    {
+        return MaxBytes != 0;
+    }
+
+    size_t GetUsed() const
+    {
+        return Used.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<size_t> Used = 0;
+    size_t MaxBytes;
+};
+
+template<typename Sig, typename SizeT = uint32_t, typename AllocatorT = QueueAllocatorRef>
+class CommandQueue;
+
+/*!
+ * Data container for for trivially copyable lambdas.
+ *
+ * \tparam Sig
+ *  Signature the commands are called with, as in `R(Args...)`. Commands are called with the queue first (so they can
+ *  access their OOB data), followed by `Args`.
+ * \tparam SizeT
+ *  Type used for offsets and sizes, which limits the queue's capacity. 64 bits allows for very big queues.
+ * \tparam AllocatorT
+ *  Where the memory comes from. Needs `Allocate`, `Free` and `TryResize` with the same semantics as QueueAllocator.
+ *  `GetUsableSize` is optional.
+ *  QueueAllocatorRef allows picking a QueueAllocator at runtime, while something like SystemQueueAllocator avoids the
+ *  virtual calls.
+ */
+template<typename R, typename... Args, typename SizeT, typename AllocatorT>
+class CommandQueue<R(Args...), SizeT, AllocatorT>
+{
+  public:
+
+    using SizeType = SizeT;
+    static_assert(std::is_unsigned_v<SizeType>);
+    
+    /**
+     * Represents a reference to something in the container
+     */
+    struct Ref
+    {
+        Ref() = default;
+        explicit Ref(SizeType pos)
+            : Pos(pos)
+        {
+        }
+
+        inline static constexpr SizeType InvalidValue = std::numeric_limits<SizeType>::max();
+
+        /**
+         * Returns true if the iterator is set (even if pointing to end())
+         * This is only useful when the user code needs to check if a reference was set to point to something or not. 
+         */
+        bool IsSet() const noexcept
+        {
+            return Pos != InvalidValue;
+        }
+
+        SizeType Pos = InvalidValue;
+    };
+
+    /*!
+     * \param capacity
+     *	Initial capacity. A value of 0 is allowed.
+     *	Capacity grows as required.
+     * \param allocator
+     *  Where the memory comes from.
+     */ 
+    CommandQueue(SizeType capacity = 0, AllocatorT allocator = AllocatorT())
+        : Allocator(std::move(allocator))
+    {
+        if (capacity)
+        {
+            capacity = GetUsableCapacity(capacity);
+            Data = static_cast<uint8_t*>(Allocator.Allocate(capacity));
+            Capacity = Data ? capacity : 0;
+        }
+    }
+
+    ~CommandQueue()
+    {
+        if (Budget)
+        {
+            Budget->Release(Capacity);
+        }
+        DestroyNonTrivials();
+        Allocator.Free(Data, Capacity);
+    }
+
+    /*!
+     * Sets where the queue's memory comes from.
+     * Anything in the queue is moved over to a block from the new allocator. Returns false if that allocation fails, in
+     * which case the queue keeps the old allocator.
+     */
+    bool SetAllocator(AllocatorT allocator)
+    {
+        if constexpr (std::equality_comparable<AllocatorT>)
+        {
+            if (allocator == Allocator)
+            {
+                return true;
+            }
+        }
+
+        if (Capacity)
+        {
+            uint8_t* newData = static_cast<uint8_t*>(allocator.Allocate(Capacity));
+            if (!newData)
+            {
+                return false;
+            }
+            MoveTo(newData);
+        }
+
+        Allocator = std::move(allocator);
+        return true;
+    }
+
+    /*!
+     * Sets a hard limit for the queue's capacity. 0 means no limit.
+     * It doesn't shrink the queue if it's already bigger.
+     */
+    void SetMaxCapacity(SizeType maxCapacity)
+    {
+        MaxCapacity = maxCapacity;
+    }
+
+    /*!
+     * Sets the budget the queue's capacity is taken from (or none, with nullptr).
+     * The current capacity is moved over to the new budget, even if that puts it over its limit.
+     */
+    void SetBudget(CommandQueueBudget* budget)
+    {
+        if (Budget)
+        {
+            Budget->Release(Capacity);
+        }
+
+        Budget = budget;
+        if (Budget)
+        {
+            Budget->ForceAcquire(Capacity);
+        }
+    }
+
+    /*!
+     * Returns true if a push failed since the last Clear, due to the capacity limits.
+     * Once that happens, all pushes fail until the queue is cleared, so that commands depending on each other (e.g a
+     * command and its OOB data) are either all in the queue or not at all.
+     */
+    bool IsOverflowed() const
+    {
+        return Overflowed;
+    }
+
+    /*!
+     * Number of pushes that failed since the last Clear
+     */
+    uint32_t GetNumFailedPushes() const
+    {
+        return NumFailedPushes;
+    }
+
+    SizeType GetCapacity() const
+    {
+        return Capacity;
+    }
+
+    /*!
+     * Bytes in use, commands and OOB data
+     */
+    SizeType GetUsedCapacity() const
+    {
+        return UsedCapacity;
+    }
+
+    /*!
+     * Makes sure the queue has a capacity of at least `capacity` bytes, within the limits.
+     * Returns false if it can't.
+     */
+    bool Reserve(SizeType capacity)
+    {
+        return capacity <= Capacity || Grow(capacity - UsedCapacity);
+    }
+
+    /*!
+     * Touches all of the unused capacity, so the OS maps the pages now, and not on the first frames that push to it.
+     * Meant to be used at startup, after Reserve.
+     */
+    void Prefault()
+    {
+        if (Data)
+        {
+            memset(Data + UsedCapacity, 0, Capacity - UsedCapacity);
+        }
+    }
+
+    /*!
+     * Controls how the capacity follows the usage, which is sampled on every Clear.
+     */
+    struct SizingPolicy
+    {
+        // Percentile of the usage in the last `UsageFrames` clears the capacity is sized for
+        float Percentile = 0.95f;
+        // Extra room on top of the percentile
+        float Headroom = 1.25f;
+        // Number of consecutive clears the predicted capacity needs to stay below half the capacity before the queue
+        // shrinks to it. 0 disables shrinking.
+        uint32_t ShrinkAfterFrames = 120;
+    };
+
+    void SetSizingPolicy(const SizingPolicy& policy)
+    {
+        Policy = policy;
+        LowUsageFrames = 0;
+        ClearsUntilSizing = 0;
+    }
+
+    /*!
+     * Capacity the usage samples call for, and what the queue would shrink to.
+     * This is what a saved profile should use to size the queue upfront. It's computed when called, so it's not meant
+     * to be called every frame.
+     */
+    SizeType GetPredictedCapacity() const
+    {
+        return ComputePredictedCapacity();
+    }
+
+    struct Base
+    {
+        Base(SizeType size)
+            : Size (size)
+        {
+        }
+
+        SizeType Size;
+        virtual R Call(CommandQueue& q, Args... args) const = 0;
+    };
+
+    /*!
+     * This acts as a wrapper for the lambdas, effectively enabling us to store different lambda types and
+     * call their function call operator
+     */
+    template<typename T>
+    struct Wrapper : public Base
+    {
+        Wrapper(T&& payload)
+            : Base(sizeof(*this))
+            , Payload(std::forward<T>(payload))
+        {
+        }
+
+        R Call(CommandQueue& q, Args... args) const override
+        {
+            return Payload(q, std::forward<Args>(args)...);
+        }
+
+        T Payload;
+    };
+
+    /*!
+     * Pushes a command, and returns a reference to it, which can be used with CallAt.
+     * If the queue has capacity limits and they don't allow it to grow, it returns an unset Ref, and the command is not
+     * pushed.
+     */
+    template<typename T>
+    Ref Push(T&& v)
+    {
+        // T needs to be copyable with memcmp
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        Ref ref = AllocCommand<Wrapper<T>>();
+        if (ref.IsSet())
+        {
+            new(Data + ref.Pos) Wrapper<T>(std::forward<T>(v));
+            if (TypeGrouping)
+            {
+                AddToBucket<T>(ref);
+            }
+        }
+        return ref;
+    }
+
+    /*!
+     * Same as Push, but for commands that are not trivially copyable (e.g capturing a std::string or a std::shared_ptr).
+     * The command is moved into the queue, and its destructor runs when the queue is cleared. If the queue grows, the
+     * command is moved to the new memory with its move constructor.
+     * This has some overhead over Push, so it should only be used when the command really needs it.
+     */
+    template<typename T>
+    Ref PushNonTrivial(T&& v)
+    {
+        static_assert(!std::is_lvalue_reference_v<T>, "Commands are moved into the queue");
+        static_assert(std::is_nothrow_move_constructible_v<T>);
+
+        Ref ref = AllocCommand<Wrapper<T>>();
+        if (ref.IsSet())
+        {
+            new(Data + ref.Pos) Wrapper<T>(std::forward<T>(v));
+            if constexpr (!std::is_trivially_copyable_v<T>)
+            {
+                NonTrivials.push_back({ref.Pos, &DestroyCmd<T>, &RelocateCmd<T>});
+            }
+            if (TypeGrouping)
+            {
+                AddToBucket<std::remove_cvref_t<T>>(ref);
+            }
+        }
+        return ref;
+    }
+
+    /*!
+     * Returns true if a PushRow to `channel` would add to the same command as the previous row, as-in, nothing else was
+     * pushed in between. Channels that encode rows relative to the previous one use this to know where a run starts.
+     */
+    template<typename Channel>
+    bool ContinuesRowRun(const Channel& channel) const
+    {
+        return !Overflowed && Last.IsSet() && RowRun.Channel == &channel && RowRun.Cmd.Pos == Last.Pos;
+    }
+
+    /*!
+     * Makes the next PushRow start a new command, even if nothing was pushed in between. Channels that keep data per run
+     * use this to start a new run when a row doesn't fit the current one.
+     */
+    void EndRowRun()
+    {
+        RowRun = {};
+    }
+
+    /*!
+     * Appends a row to a struct-of-arrays command channel (see CommandColumns).
+     * Consecutive rows to the same channel share a single command in the queue, which calls
+     * `Channel::CallRange(q, channel, begin, count, args...)` for all of them, so the order relative to the other commands
+     * is kept, but the queue itself only holds a small command per run of rows.
+     * The channel needs to outlive the commands, and be cleared together with the queue.
+     * Returns false if the queue's capacity limits don't allow it, in which case the row is not appended.
+     */
+    template<typename Channel, typename... Vs>
+    bool PushRow(Channel& channel, Vs&&... values)
+    {
+        if (!ContinuesRowRun(channel))
+        {
+            Ref ref = Push(RowRangeCmd<Channel>{&channel, channel.GetSize(), 0});
+            if (!ref.IsSet())
+            {
+                return false;
+            }
+            RowRun = {&channel, ref};
+        }
+
+        channel.Append(std::forward<Vs>(values)...);
+        static_cast<Wrapper<RowRangeCmd<Channel>>&>(At(RowRun.Cmd)).Payload.Count++;
+        return true;
+    }
+
+    /*!
+     * Reserves space for `count` elements of type T as OOB data, and returns a reference to it.
+     * The size is only limited by SizeType, and the data is aligned to `alignof(T)`.
+     * If the queue's capacity limits don't allow it, it returns an unset Ref.
+     */
+    template<typename T>
+    Ref OobPushEmpty(size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(alignof(T) <= details::MaxAlignment);
+
+        // Padding needed to align the data. The size itself is rounded up so that whatever comes next stays aligned.
+        const SizeType padding = details::RoundUpToMultipleOf(UsedCapacity, static_cast<SizeType>(alignof(T))) - UsedCapacity;
+        // Anything that can't be represented with SizeType fails the push, like any other capacity limit
+        const size_t used = static_cast<size_t>(UsedCapacity) + padding + sizeof(size_t);
+        const size_t maxBytes = used < std::numeric_limits<SizeType>::max() ? std::numeric_limits<SizeType>::max() - used : 0;
+        if (count > maxBytes / sizeof(T))
+        {
+            Overflowed = true;
+            NumFailedPushes++;
+            return Ref();
+        }
+        const size_t bytes = count * sizeof(T);
+
+        SizeType alignedNeededCapacity = padding + details::RoundUpToMultipleOf(static_cast<SizeType>(bytes), static_cast<SizeType>(sizeof(size_t)));
+        if (!EnsureFreeCapacity(alignedNeededCapacity))
+        {
+            return Ref();
+        }
+
+        Ref res(UsedCapacity + padding);
+        UsedCapacity += alignedNeededCapacity;
+        if (Last.IsSet())
+        {
+            At(Last).Size += alignedNeededCapacity;
+        }
+
+        return res;
+    }
+
+    /*!
+     * Pushes an OOB raw data.
+     * OOB means "out of band", since it's data that the iterators don't see.
+     * The purpose of this kind of data is for when you need to insert raw data into the vector that other objects need to use.
+     */
+    template<typename T>
+    Ref OobPush(const T* data, size_t count)
+    {
+        Ref res = OobPushEmpty<T>(count);
+        if (res.IsSet())
+        {
+            memcpy(Data + res.Pos, data, count * sizeof(T));
+        }
+        return res;
+    }
+
+    /*!
+     * Shrinks the most recent OOB push to `bytes`, giving back the unused space.
+     * This allows reserving OOB space for data of unknown size (e.g text formatting), and only keeping what was used.
+     * **IMPORTANT**: `ref` needs to be the last thing pushed to the queue.
+     */
+    void OobTrim(Ref ref, size_t bytes)
+    {
+        SizeType newUsedCapacity = details::RoundUpToMultipleOf(static_cast<SizeType>(ref.Pos + bytes), static_cast<SizeType>(sizeof(size_t)));
+        assert(ref.Pos <= UsedCapacity && newUsedCapacity <= UsedCapacity);
+        SizeType diff = UsedCapacity - newUsedCapacity;
+        UsedCapacity = newUsedCapacity;
+        if (Last.IsSet())
+        {
+            At(Last).Size -= diff;
+        }
+    }
+
+    /*!
+     * Returns a pointer to an oob data
+     */
+    uint8_t* OobAt(Ref ref) const
+    {
+        assert(ref.Pos < UsedCapacity);
+        return Data + ref.Pos;
+    }
+
+    /*!
+     * Give an oob reference, it returns it's data pointer, cast to the specified type
+     */
+    template<typename T>
+    T& OobAtAs(Ref ref) const
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return *reinterpret_cast<T*>(OobAt(ref));
+    }
+
+    /*!
+     * Runs all the commands
+     */
+    void CallAll(Args... args)
+    {
+        const uint8_t* ptr = Data + (First.IsSet() ? First.Pos : 0);
+        SizeType todo = NumElements;
+        while (todo--)
+        {
+            const Base* op = reinterpret_cast<const Base*>(ptr);
+            ptr += op->Size;
+            op->Call(*this, args...);
+        }
+    }
+
+    /*!
+     * Same as CallAll, but calls `onChunk()` before every `chunkSize` commands, and stops if it returns false.
+     * This allows checking things like a time budget without the cost of doing it for every command.
+     * Returns the number of commands that were not run.
+     */
+    template<typename F>
+    SizeType CallAllChunked(SizeType chunkSize, F&& onChunk, Args... args)
+    {
+        assert(chunkSize);
+        const uint8_t* ptr = Data + (First.IsSet() ? First.Pos : 0);
+        SizeType todo = NumElements;
+        while (todo)
+        {
+            if (!onChunk())
+            {
+                return todo;
+            }
+
+            SizeType count = std::min(todo, chunkSize);
+            todo -= count;
+            while (count--)
+            {
+                const Base* op = reinterpret_cast<const Base*>(ptr);
+                ptr += op->Size;
+                op->Call(*this, args...);
+            }
+        }
+
+        return 0;
+    }
+
+    /*!
+     * Calls `func(Ref)` for every command, in the order they were pushed, without running them.
+     * Together with CallAt, this allows running the commands in a different order, or skipping some.
+     */
+    template<typename F>
+    void ForEachRef(F&& func) const
+    {
+        SizeType pos = First.IsSet() ? First.Pos : 0;
+        SizeType todo = NumElements;
+        while (todo--)
+        {
+            SizeType next = pos + reinterpret_cast<const Base*>(Data + pos)->Size;
+            func(Ref(pos));
+            pos = next;
+        }
+    }
+
+    /*!
+     * Runs a single command
+     */
+    R CallAt(Ref ref, Args... args)
+    {
+        return At(ref).Call(*this, std::forward<Args>(args)...);
+    }
+
+    SizeType GetNumElements() const
+    {
+        return NumElements;
+    }
+
+    /*!
+     * View of the commands of type T in the queue, as given to `T::CallBatch` (see CallAllGrouped)
+     */
+    template<typename T>
+    class Batch
+    {
+      public:
+        Batch(CommandQueue& q, const SizeType* refs, SizeType count)
+            : Q(q)
+            , Refs(refs)
+            , Count(count)
+        {
+        }
+
+        SizeType GetSize() const
+        {
+            return Count;
+        }
+
+        const T& operator[](SizeType index) const
+        {
+            assert(index < Count);
+            return static_cast<const Wrapper<T>&>(Q.At(Ref(Refs[index]))).Payload;
+        }
+
+      private:
+        CommandQueue& Q;
+        const SizeType* Refs;
+        SizeType Count;
+    };
+
+    /*!
+     * Enables keeping a list of commands per type, as they are pushed, which allows running them with CallAllGrouped.
+     * This costs a bit on every push, so it's off by default. Can only be changed while the queue is empty.
+     */
+    void SetTypeGrouping(bool enabled)
+    {
+        assert(NumElements == 0);
+        TypeGrouping = enabled;
+    }
+
+    bool IsTypeGrouping() const
+    {
+        return TypeGrouping;
+    }
+
+    /*!
+     * Runs all the commands, grouped by type, in the order each type was first pushed. Commands of the same type run in
+     * the order they were pushed, but there is no order across types, so this is only for queues where that doesn't
+     * matter.
+     * Each type's commands are run in a tight loop without virtual calls. If a type declares
+     * `static void CallBatch(CommandQueue& q, const CommandQueue::Batch<T>& batch, Args... args)`, that is called
+     * instead, once with all the commands of that type.
+     * Requires SetTypeGrouping(true).
+     */
+    void CallAllGrouped(Args... args)
+    {
+        assert(TypeGrouping);
+        for (TypeBucket& bucket : Buckets)
+        {
+            if (!bucket.Refs.empty())
+            {
+                bucket.Run(*this, bucket.Refs.data(), static_cast<SizeType>(bucket.Refs.size()), args...);
+            }
+        }
+    }
+
+    /*!
+     * Same as CallAllGrouped, but only runs the commands for which `filter(Ref)` returns true.
+     */
+    template<typename F>
+    void CallAllGroupedIf(F&& filter, Args... args)
+    {
+        assert(TypeGrouping);
+        for (TypeBucket& bucket : Buckets)
+        {
+            FilteredRefs.clear();
+            for (SizeType pos : bucket.Refs)
+            {
+                if (filter(Ref(pos)))
+                {
+                    FilteredRefs.push_back(pos);
+                }
+            }
+
+            if (!FilteredRefs.empty())
+            {
+                bucket.Run(*this, FilteredRefs.data(), static_cast<SizeType>(FilteredRefs.size()), args...);
+            }
+        }
+    }
+
+    /*!
+     * Clears the queue.
+     * The queues are meant to be cleared once per frame, so this also samples the usage, and shrinks the queue if the
+     * sizing policy says so.
+     */
+    void Clear()
+    {
+        DestroyNonTrivials();
+        // Buckets are kept, since the same types are likely to be pushed again
+        for (TypeBucket& bucket : Buckets)
+        {
+            bucket.Refs.clear();
+        }
+
+        Usage[UsageIndex] = UsedCapacity;
+        UsageIndex = (UsageIndex + 1) % UsageFrames;
+        NumUsageSamples = std::min(NumUsageSamples + 1, UsageFrames);
+
+        UsedCapacity = 0;
+        NumElements = 0;
+        First = {};
+        Last = {};
+        Overflowed = false;
+        NumFailedPushes = 0;
+        RowRun = {};
+
+        UpdateSizing();
+    }
+
+  private:
+
+    /*!
+     * Makes room for a command of type W (a Wrapper), and returns where to construct it, or an unset Ref if the capacity
+     * limits don't allow it.
+     */
+    template<typename W>
+    Ref AllocCommand()
+    {
+        static_assert(alignof(W) <= details::MaxAlignment);
+
+        // Everything pushed keeps the queue aligned to at least alignof(Base), so only over-aligned payloads need padding
+        SizeType padding = 0;
+        if constexpr (alignof(W) > alignof(Base))
+        {
+            padding = details::RoundUpToMultipleOf(UsedCapacity, static_cast<SizeType>(alignof(W))) - UsedCapacity;
+        }
+
+        static constexpr size_t needed = sizeof(W);
+
+        if (!EnsureFreeCapacity(padding + needed))
+        {
+            return Ref();
+        }
+
+        // The padding becomes part of the previous command, the same way OOB data does
+        if (padding && Last.IsSet())
+        {
+            At(Last).Size += padding;
+        }
+
+        SizeType offset = UsedCapacity + padding;
+        UsedCapacity = offset + needed;
+        ++NumElements;
+
+        if (!First.IsSet())
+        {
+            First = Ref(offset);
+        }
+
+        Last = Ref(offset);
+        return Last;
+    }
+
+    template<typename T>
+    static void DestroyCmd(uint8_t* ptr)
+    {
+        std::launder(reinterpret_cast<Wrapper<T>*>(ptr))->~Wrapper<T>();
+    }
+
+    template<typename T>
+    static void RelocateCmd(uint8_t* dst, uint8_t* src)
+    {
+        Wrapper<T>* from = std::launder(reinterpret_cast<Wrapper<T>*>(src));
+        // Size includes any OOB data pushed after the command, which the constructor doesn't know about
+        Wrapper<T>* to = new(dst) Wrapper<T>(std::move(from->Payload));
+        to->Size = from->Size;
+        from->~Wrapper<T>();
+    }
+
+    // Command PushRow pushes for a run of rows
+    template<typename Channel>
+    struct RowRangeCmd
+    {
+        Channel* Columns;
+        uint32_t Begin;
+        uint32_t Count;
+
+        void operator()(CommandQueue& q, Args... args) const
+        {
+            Channel::CallRange(q, *Columns, Begin, Count, args...);
+        }
+    };
+
+    // Unique per command type. Not const, so the linker can't fold them together.
+    template<typename T>
+    inline static char TypeTag = 0;
+
+    template<typename T>
+    static constexpr bool HasCallBatch = requires(CommandQueue& q, const Batch<T>& batch, Args... args)
+    {
+        T::CallBatch(q, batch, args...);
+    };
+
+    template<typename T>
+    static void RunBatch(CommandQueue& q, const SizeType* refs, SizeType count, Args... args)
+    {
+        if constexpr (HasCallBatch<T>)
+        {
+            T::CallBatch(q, Batch<T>(q, refs, count), args...);
+        }
+        else
+        {
+            for (SizeType i = 0; i < count; i++)
+            {
+                static_cast<const Wrapper<T>&>(q.At(Ref(refs[i]))).Payload(q, args...);
+            }
+        }
+    }
+
+    template<typename T>
+    void AddToBucket(Ref ref)
+    {
+        // Commands of the same type tend to be pushed in runs, so check the last used bucket first
+        if (LastBucket >= Buckets.size() || Buckets[LastBucket].TypeKey != &TypeTag<T>)
+        {
+            LastBucket = 0;
+            while (LastBucket < Buckets.size() && Buckets[LastBucket].TypeKey != &TypeTag<T>)
+            {
+                LastBucket++;
+            }
+
+            if (LastBucket == Buckets.size())
+            {
+                Buckets.push_back({&TypeTag<T>, &RunBatch<T>, {}});
+            }
+        }
+
+        Buckets[LastBucket].Refs.push_back(ref.Pos);
+    }
+
+    /*!
+     * Runs the destructors of the non-trivial commands, in reverse order
+     */
+    void DestroyNonTrivials()
+    {
+        for (auto it = NonTrivials.rbegin(); it != NonTrivials.rend(); ++it)
+        {
+            it->Destroy(Data + it->Pos);
+        }
+        NonTrivials.clear();
+    }
+
+    /*!
+     * Percentile of the usage samples, plus headroom, rounded up to a power of 2
+     */
+    SizeType ComputePredictedCapacity() const
+    {
+        if (NumUsageSamples == 0)
+        {
+            return static_cast<SizeType>(MinCapacity);
+        }
+
+        SizeType sorted[UsageFrames];
+        std::copy_n(Usage, NumUsageSamples, sorted);
+        const int k = std::clamp(static_cast<int>(Policy.Percentile * static_cast<float>(NumUsageSamples - 1) + 0.5f), 0, NumUsageSamples - 1);
+        std::nth_element(sorted, sorted + k, sorted + NumUsageSamples);
+
+        const size_t limit = MaxCapacity ? MaxCapacity : std::numeric_limits<SizeType>::max();
+        const size_t wanted = static_cast<size_t>(static_cast<double>(sorted[k]) * Policy.Headroom);
+        return static_cast<SizeType>(std::min(std::max(details::RoundPow2(wanted), MinCapacity), limit));
+    }
+
+    /*!
+     * Shrinks the queue to the predicted capacity if it's been well below the capacity for long enough.
+     * The prediction is only refreshed every `SizingInterval` clears, and not at all if shrinking is disabled, so most
+     * clears don't pay for the percentile.
+     * Must be called when the queue is empty.
+     */
+    void UpdateSizing()
+    {
+        if (Policy.ShrinkAfterFrames == 0)
+        {
+            LowUsageFrames = 0;
+            return;
+        }
+
+        if (ClearsUntilSizing == 0)
+        {
+            PredictedCapacity = ComputePredictedCapacity();
+            ClearsUntilSizing = SizingInterval;
+        }
+        ClearsUntilSizing--;
+
+        // Compared with what the allocator would actually give us, otherwise a rounding allocator would have us
+        // reallocate to the same size over and over
+        const SizeType shrinkCapacity = GetUsableCapacity(PredictedCapacity);
+        if (Capacity <= static_cast<size_t>(shrinkCapacity) * 2)
+        {
+            LowUsageFrames = 0;
+            return;
+        }
+
+        if (++LowUsageFrames >= Policy.ShrinkAfterFrames)
+        {
+            const SizeType oldCapacity = Capacity;
+            if (Reallocate(shrinkCapacity) && Budget)
+            {
+                Budget->Release(oldCapacity - Capacity);
+            }
+            LowUsageFrames = 0;
+        }
+    }
+
+    /*!
+     * Given a Ref, it returns the object at that position.
+     */
+    Base& At(Ref ref)
+    {
+        assert(ref.Pos < UsedCapacity);
+        return *reinterpret_cast<Base*>(Data + ref.Pos);
+    }
+
+    /*!
+     * Returns the free capacity, in bytes
+     */
+    SizeType GetFreeCapacity() const
+    {
+        return Capacity - UsedCapacity;
+    }
+
+    /*!
+     * Grows the container if it doesn't have `bytes` of free capacity.
+     * Returns false (and sets the queue as overflowed) if it can't.
+     */
+    bool EnsureFreeCapacity(size_t bytes)
+    {
+        if (!Overflowed && (GetFreeCapacity() >= bytes || Grow(static_cast<SizeType>(bytes))))
+        {
+            return true;
+        }
+
+        Overflowed = true;
+        NumFailedPushes++;
+        return false;
+    }
+
+    /*!
+     * Grows the container so it has at least the specified amount of free bytes
+     * Returns false if the capacity limits don't allow it.
+     */
+    bool Grow(SizeType requiredFreeCapacity)
+    {
+        const size_t needed = static_cast<size_t>(UsedCapacity) + requiredFreeCapacity;
+        const size_t limit = MaxCapacity ? MaxCapacity : std::numeric_limits<SizeType>::max();
+        if (needed > limit)
+        {
+            return false;
+        }
+
+        // For very big queues the next power of 2 might not fit in the limit, in which case we take what we can.
+        // If the budget doesn't allow that either, we try again with just what we need.
+        // Either way, the capacity is what the allocator really gives us, so that's what the budget is charged.
+        SizeType newCapacity = GetUsableCapacity(std::min(details::RoundPow2(needed), limit));
+        if (Budget && !Budget->TryAcquire(newCapacity - Capacity))
+        {
+            newCapacity = GetUsableCapacity(needed);
+            if (!Budget->TryAcquire(newCapacity - Capacity))
+            {
+                return false;
+            }
+        }
+
+        if (!Reallocate(newCapacity))
+        {
+            if (Budget)
+            {
+                Budget->Release(newCapacity - Capacity);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+     * Returns the capacity a block of `bytes` really has, as reported by the allocator, within the capacity limits.
+     */
+    SizeType GetUsableCapacity(size_t bytes) const
+    {
+        size_t usable = bytes;
+        if constexpr (requires { Allocator.GetUsableSize(bytes); })
+        {
+            usable = std::max(static_cast<size_t>(Allocator.GetUsableSize(bytes)), bytes);
+        }
+
+        const size_t limit = MaxCapacity ? MaxCapacity : std::numeric_limits<SizeType>::max();
+        return static_cast<SizeType>(std::min(usable, limit));
+    }
+
+    /*!
+     * Changes the capacity, which needs to fit what is in use. The allocator is given the chance to resize the block in
+     * place, otherwise the data is moved to a new block.
+     * Returns false if the allocator fails.
+     */
+    bool Reallocate(SizeType newCapacity)
+    {
+        assert(newCapacity >= UsedCapacity);
+
+        if (Data && Allocator.TryResize(Data, Capacity, newCapacity))
+        {
+            Capacity = newCapacity;
+            return true;
+        }
+
+        // Offsets are kept as-is, so the block needs to be aligned for what is in it to stay aligned
+        uint8_t* newData = static_cast<uint8_t*>(Allocator.Allocate(newCapacity));
+        if (!newData)
+        {
+            return false;
+        }
+
+        MoveTo(newData);
+        Capacity = newCapacity;
+        return true;
+    }
+
+    /*!
+     * Moves what is in use to a new block, and frees the current one.
+     */
+    void MoveTo(uint8_t* newData)
+    {
+        if (Data)
+        {
+            memcpy(newData, Data, UsedCapacity);
+            // memcpy is enough for everything else, but non-trivial commands need to be moved properly
+            for (const NonTrivialCmd& cmd : NonTrivials)
+            {
+                cmd.Relocate(newData + cmd.Pos, Data + cmd.Pos);
+            }
+            Allocator.Free(Data, Capacity);
+        }
+
+        Data = newData;
+    }
+
+    /*!
+     * Buffer where the elements are kept
+     */
+    uint8_t* Data = nullptr;
+
+    /*!
+     * Since the elements put into the container can be of different sizes, any mention of capacity therefore are in bytes.
+     * not the number of elements, since that is unknown. As-in, there is no way to know how many elements will fit in the
+     * available capacity.
+     */
+    SizeType Capacity = 0;
+    SizeType UsedCapacity = 0;
+
+    /*!
+     * Number of elements in the container
+     */
+    SizeType NumElements = 0;
+
+    /*!
+     * Reference to the first inserted element and the last.
+     * This is needed to support OOB data.
+     */
+    Ref First;
+    Ref Last;
+
+    AllocatorT Allocator;
+
+    // Capacity limits
+    SizeType MaxCapacity = 0;
+    CommandQueueBudget* Budget = nullptr;
+    bool Overflowed = false;
+    uint32_t NumFailedPushes = 0;
+
+    // Commands pushed with PushNonTrivial, that need to be relocated and destroyed
+    struct NonTrivialCmd
+    {
+        SizeType Pos;
+        void (*Destroy)(uint8_t* ptr);
+        void (*Relocate)(uint8_t* dst, uint8_t* src);
+    };
+    std::vector<NonTrivialCmd> NonTrivials;
+
+    // Commands per type, if type grouping is enabled
+    struct TypeBucket
+    {
+        const char* TypeKey;
+        void (*Run)(CommandQueue& q, const SizeType* refs, SizeType count, Args... args);
+        std::vector<SizeType> Refs;
+    };
+    bool TypeGrouping = false;
+    std::vector<TypeBucket> Buckets;
+    size_t LastBucket = 0;
+    // Scratch space for CallAllGroupedIf
+    std::vector<SizeType> FilteredRefs;
+
+    // Channel and command of the last PushRow, so following rows can be added to the same command
+    struct
+    {
+        const void* Channel = nullptr;
+        Ref Cmd;
+    } RowRun;
+
+    // Bytes used in the last few frames, to size the queue
+    inline static constexpr int UsageFrames = 32;
+    inline static constexpr size_t MinCapacity = 1024;
+    SizeType Usage[UsageFrames] = {};
+    int UsageIndex = 0;
+    int NumUsageSamples = 0;
+    SizingPolicy Policy;
+    // Clears between refreshes of PredictedCapacity, when shrinking is enabled
+    inline static constexpr uint32_t SizingInterval = 8;
+    uint32_t ClearsUntilSizing = 0;
+    // As of the last refresh. Only used to decide when to shrink.
+    SizeType PredictedCapacity = 0;
+    uint32_t LowUsageFrames = 0;
+};
+
+#if defined(_MSVC_LANG)
+        __pragma(warning(pop))
+#endif
+
@@ -0,0 +1,126 @@
+/*******************************************************************************************
+*
+*   Column storage for DrawCubeEx.
+*
+*   When a group doesn't sort, RenderQueue::DrawCubeEx appends the cube as a row of the group's cube columns (see
+*   CommandColumns), instead of queuing a command per cube. The render thread then gets one call per run of cubes,
+*   culls them, and draws the visible ones, all the cubes first and then all the wireframes.
+*
+*   - CubeColumns: Full precision, at 49 bytes per cube.
+*   - CompactCubeColumns: Quantized (see RenderQueue::SetCompactCommands), at 29 bytes per cube.
+*
+*   The RenderQueue only owns and clears the columns. Encoding, decoding and drawing the rows lives here.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "RenderCmdQueue.h"
+#include "CommandColumns.h"
+
+#include "raylib.h"
+
+#include <cstdint>
+#include <vector>
+
+// Defined in RenderQueue.h
+enum class RenderImportance : uint8_t;
+
+/*!
+ * DrawCubeEx data, one column per field.
+ */
+struct CubeColumns : CommandColumns<Vector3, Vector3, float, Vector3, Color, Color, RenderImportance>
+{
+    enum Column
+    {
+        Position,
+        RotationAxis,
+        Degrees,
+        Size,
+        CubeColor,
+        WiresColor,
+        Importance
+    };
+
+    /*!
+     * Pushes a cube as a row of `columns`, merging it with the previous row's command if possible (see
+     * CommandQueue::PushRow).
+     */
+    static bool Push(RenderCmdQueue& q, CubeColumns& columns, Vector3 position, float degrees, Vector3 rotationAxis, float width, float height,
+        float length, Color color, Color wcolor, RenderImportance importance);
+
+    static void CallRange(RenderCmdQueue& q, const CubeColumns& columns, uint32_t begin, uint32_t count);
+
+    /*!
+     * Render side. Drops and culls rows of cubes (see RenderQueue::GetVisibleCubeRows), and draws the rest.
+     * Also used for rows that don't come from the columns (e.g a CubeSnapshot).
+     * \param importances Can be nullptr if the rows can't be dropped individually.
+     */
+    static void DrawRows(const Vector3* positions, const Vector3* axes, const float* degrees, const Vector3* sizes, const Color* cubeColors,
+        const Color* wiresColors, const RenderImportance* importances, uint32_t count);
+};
+
+/*!
+ * Same as CubeColumns, but quantized, at 29 bytes per cube instead of 49, plus 16 bytes per run.
+ * Each run has a full precision base position, and rows are fixed point deltas from it (PositionScale), so a run decodes
+ * without looking at any other run, and the error doesn't depend on how far the cubes are from the origin. A row too far
+ * from the base for the deltas starts a new run.
+ */
+struct CompactCubeColumns : CommandColumns<int16_t, int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t, uint16_t, uint16_t, uint16_t,
+                                           Color, Color, RenderImportance>
+{
+    enum Column
+    {
+        DeltaX,
+        DeltaY,
+        DeltaZ,
+        AxisX,
+        AxisY,
+        AxisZ,
+        Angle,
+        Width,
+        Height,
+        Length,
+        CubeColor,
+        WiresColor,
+        Importance
+    };
+
+    // Steps per unit of the position deltas. Deltas have a range of +-512, and are within 1/128 of the real ones.
+    inline static constexpr float PositionScale = 64.0f;
+
+    struct RunBase
+    {
+        // First row of the run
+        uint32_t Begin;
+        Vector3 Position;
+    };
+    // One per run, sorted by Begin, since runs are pushed in order
+    std::vector<RunBase> Bases;
+
+    void Clear()
+    {
+        CommandColumns::Clear();
+        Bases.clear();
+    }
+
+    size_t GetUsedBytes() const
+    {
+        return CommandColumns::GetUsedBytes() + Bases.size() * sizeof(RunBase);
+    }
+
+    /*!
+     * Encodes a cube as a row of `columns`.
+     * Returns false if the cube can't be encoded (sizes out of range), in which case it should be pushed at full precision.
+     * A push that fails because the queue can't grow still returns true, since it would fail at full precision too.
+     */
+    static bool Push(RenderCmdQueue& q, CompactCubeColumns& columns, Vector3 position, float degrees, Vector3 rotationAxis, float width,
+        float height, float length, Color color, Color wcolor, RenderImportance importance);
+
+    static void CallRange(RenderCmdQueue& q, const CompactCubeColumns& columns, uint32_t begin, uint32_t count);
+};
@@ -0,0 +1,178 @@
+/*******************************************************************************************
+*
+*   Linear allocator for memory that only needs to live until the end of the frame.
+*
+*   Each FrameThread owns one, and resets it at the start of every frame, so Update can use it for temporary memory
+*   (sorting scratch, culling lists, formatting) without going to the heap.
+*   - Allocations bump a pointer in a single block, and deallocation is a no-op, except for the most recent allocation,
+*     which is given back (e.g scratch that is freed right away).
+*   - When the block is full, allocations overflow to the upstream resource, and are freed in bulk at the next reset.
+*     The reset then grows the block to what the frame needed, so after a few frames, there are no heap allocations
+*     per frame at all.
+*   - It's a std::pmr::memory_resource, so std::pmr containers can use it directly.
+*   - It's not thread safe. Only the thread that owns it should use it.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+class FrameArena : public std::pmr::memory_resource
+{
+  public:
+
+    /*!
+     * \param capacity
+     *      Initial size of the block. It grows as needed, when reset. 0 is treated as 1, so it can grow by doubling.
+     * \param upstream
+     *      Where the block and the overflowing allocations come from
+     */
+    explicit FrameArena(size_t capacity = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : Upstream(upstream)
+        , Capacity(std::max<size_t>(capacity, 1))
+    {
+        Block = static_cast<uint8_t*>(Upstream->allocate(Capacity, BlockAlignment));
+    }
+
+    ~FrameArena() override
+    {
+        FreeOverflows();
+        Upstream->deallocate(Block, Capacity, BlockAlignment);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /*!
+     * Frees everything allocated since the last reset.
+     * If anything overflowed, the block grows to fit everything the frame used.
+     */
+    void Reset()
+    {
+        const size_t frameBytes = Used + OverflowBytes;
+        HighWater = std::max(HighWater, frameBytes);
+
+        const bool overflowed = !Overflows.empty();
+        FreeOverflows();
+        if (overflowed)
+        {
+            // Some headroom, so a frame that needs a bit more doesn't overflow again
+            size_t newCapacity = Capacity;
+            while (newCapacity < frameBytes + frameBytes / 4)
+            {
+                newCapacity *= 2;
+            }
+
+            Upstream->deallocate(Block, Capacity, BlockAlignment);
+            Capacity = newCapacity;
+            Block = static_cast<uint8_t*>(Upstream->allocate(Capacity, BlockAlignment));
+        }
+
+        Used = 0;
+        LastPos = 0;
+    }
+
+    /*!
+     * Bytes allocated since the last reset, including the ones that overflowed
+     */
+    size_t GetUsedBytes() const
+    {
+        return Used + OverflowBytes;
+    }
+
+    size_t GetCapacity() const
+    {
+        return Capacity;
+    }
+
+    /*!
+     * Most bytes a frame used so far
+     */
+    size_t GetHighWater() const
+    {
+        return std::max(HighWater, Used + OverflowBytes);
+    }
+
+    /*!
+     * Number of allocations that overflowed to the upstream resource, since the arena was created
+     */
+    uint64_t GetNumOverflows() const
+    {
+        return NumOverflows;
+    }
+
+  private:
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        const size_t pos = (Used + alignment - 1) & ~(alignment - 1);
+        if (alignment <= BlockAlignment && pos + bytes <= Capacity)
+        {
+            LastPos = pos;
+            Used = pos + bytes;
+            return Block + pos;
+        }
+
+        // Slow path
+        void* ptr = Upstream->allocate(bytes, alignment);
+        Overflows.push_back({ptr, bytes, alignment});
+        OverflowBytes += bytes;
+        NumOverflows++;
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, [[maybe_unused]] size_t alignment) override
+    {
+        // Only the last allocation can be given back. Anything else is freed at the next reset.
+        if (ptr == Block + LastPos && LastPos + bytes == Used)
+        {
+            Used = LastPos;
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void FreeOverflows()
+    {
+        for (const Overflow& overflow : Overflows)
+        {
+            Upstream->deallocate(overflow.Ptr, overflow.Bytes, overflow.Alignment);
+        }
+        Overflows.clear();
+        OverflowBytes = 0;
+    }
+
+    inline static constexpr size_t BlockAlignment = 64;
+
+    struct Overflow
+    {
+        void* Ptr;
+        size_t Bytes;
+        size_t Alignment;
+    };
+
+    std::pmr::memory_resource* Upstream;
+    uint8_t* Block = nullptr;
+    size_t Capacity;
+    size_t Used = 0;
+    // Offset of the most recent allocation
+    size_t LastPos = 0;
+
+    std::vector<Overflow> Overflows;
+    size_t OverflowBytes = 0;
+    size_t HighWater = 0;
+    uint64_t NumOverflows = 0;
+};
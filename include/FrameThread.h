@@ -14,6 +14,7 @@
 
 #include "Common.h"
 #include "FPSCalculator.h"
+#include "FrameArena.h"
 
 #include <thread>
 #include <string_view>
@@ -80,7 +81,7 @@ public:
 
     virtual ~FrameThread()
     {
-        Th.join();
+        Join();
     }
 
     void Start()
@@ -96,6 +97,7 @@ public:
 
                 // Do the work for the current frame
                 auto start = std::chrono::high_resolution_clock::now();
+                Arena.Reset();
                 Update();
                 DOLOG("%s: Work done\n", Name.c_str());
                 WorkCalc.Tick(std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count());;
@@ -109,6 +111,19 @@ public:
         });
     }
 
+    /*!
+     * Waits for the thread to finish, once Control.ShouldFinish is set.
+     * Call it before destroying anything the thread uses (e.g: the RenderQueue), since global threads are otherwise only
+     * joined after main returns.
+     */
+    void Join()
+    {
+        if (Th.joinable())
+        {
+            Th.join();
+        }
+    }
+
     /*!
      * Returns the average time (in ms) that the work is taking each frame for this thread.
      */
@@ -137,6 +152,10 @@ protected:
     // Abusing the fps calculator to calculate how long the work takes
     FPSCalculator<> WorkCalc;
 
+    // Temporary memory for Update. Reset at the start of every frame, so nothing allocated from it can be used after
+    // Update returns (e.g by the render thread).
+    FrameArena Arena;
+
     FrameThreadControl& Control;
     std::string Name;
 
@@ -0,0 +1,64 @@
+/*******************************************************************************************
+*
+*   View frustum, for culling bounding spheres.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#include <cmath>
+
+struct Frustum
+{
+    // Plane equations (a, b, c, d), normalized, with the normals pointing inwards.
+    // Order is left, right, bottom, top, near, far.
+    Vector4 Planes[6];
+
+    /*!
+     * Extracts the planes from a view * projection matrix (as in raymath's MatrixMultiply(view, projection))
+     */
+    static Frustum FromMatrix(const Matrix& m)
+    {
+        // Rows of the matrix, as raymath's Vector3Transform applies it
+        const Vector4 r0 = {m.m0, m.m4, m.m8, m.m12};
+        const Vector4 r1 = {m.m1, m.m5, m.m9, m.m13};
+        const Vector4 r2 = {m.m2, m.m6, m.m10, m.m14};
+        const Vector4 r3 = {m.m3, m.m7, m.m11, m.m15};
+
+        auto add = [](const Vector4& a, const Vector4& b, float sign) -> Vector4
+        {
+            Vector4 p = {a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z, a.w + sign * b.w};
+            const float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+            if (len > 0.0f)
+            {
+                p = {p.x / len, p.y / len, p.z / len, p.w / len};
+            }
+            return p;
+        };
+
+        return Frustum{{add(r3, r0, 1), add(r3, r0, -1), add(r3, r1, 1), add(r3, r1, -1), add(r3, r2, 1), add(r3, r2, -1)}};
+    }
+
+    /*!
+     * Returns false if the sphere is fully outside the frustum.
+     * Conservative, as-in, it can return true for some spheres that are just outside near the corners.
+     */
+    bool IsSphereVisible(const Vector3& center, float radius) const
+    {
+        for (const Vector4& p : Planes)
+        {
+            if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,373 @@
+/*******************************************************************************************
+*
+*   Arena for out of band data that needs to outlive a single RenderCmdQueue frame.
+*
+*   OOB data pushed into a RenderCmdQueue dies when the queue is cleared, so anything constant
+*   (static strings, lookup tables, etc) would have to be copied into the queue every frame.
+*   Instead, that data can be allocated here once, with an explicit lifetime, and render
+*   commands capture the returned Ref.
+*
+*   - Memory is bump allocated from pages. Allocations with the same expiry share a generation,
+*     and a generation's pages are freed in bulk once it expires.
+*   - Since there are two queue sets, data can still be referenced by the set the render thread
+*     is processing after the logic thread is done with it. Generations are therefore only
+*     freed after the render thread is guaranteed to be done with them.
+*   - Allocation and release can be done from any logic side thread. The render thread only
+*     reads the data.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <string_view>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+class PersistentArena
+{
+  public:
+
+    /*!
+     * How long an allocation stays valid.
+     */
+    struct Lifetime
+    {
+        /*!
+         * Valid for commands queued in the current frame only
+         */
+        static Lifetime Frame()
+        {
+            return {1};
+        }
+
+        /*!
+         * Valid for commands queued in the current frame and the next `numFrames - 1` frames
+         */
+        static Lifetime Frames(uint32_t numFrames)
+        {
+            assert(numFrames > 0);
+            return {numFrames};
+        }
+
+        /*!
+         * Valid until explicitly released with PersistentArena::Release
+         */
+        static Lifetime UntilReleased()
+        {
+            return {0};
+        }
+
+        // 0 means "until released"
+        uint32_t NumFrames;
+    };
+
+    /*!
+     * Handle to an allocation. It's trivially copyable, so render commands can capture it.
+     */
+    struct Ref
+    {
+        uint8_t* Ptr = nullptr;
+        uint32_t Size = 0;
+        uint32_t GenerationId = 0;
+
+        bool IsSet() const noexcept
+        {
+            return Ptr != nullptr;
+        }
+    };
+
+    /*!
+     * \param pageSize
+     *      Size of the pages the allocations are taken from. Bigger allocations get a dedicated page.
+     */
+    explicit PersistentArena(uint32_t pageSize = 64 * 1024)
+        : PageSize(pageSize)
+    {
+    }
+
+    ~PersistentArena()
+    {
+        for (Generation& gen : Generations)
+        {
+            FreePages(gen.Pages);
+        }
+
+        while (FreeList)
+        {
+            Page* next = FreeList->Next;
+            free(FreeList);
+            FreeList = next;
+        }
+    }
+
+    PersistentArena(const PersistentArena&) = delete;
+    PersistentArena& operator=(const PersistentArena&) = delete;
+
+    /*!
+     * Allocates uninitialized memory.
+     */
+    Ref Alloc(size_t size, size_t alignment, Lifetime lifetime)
+    {
+        assert(alignment && (alignment & (alignment - 1)) == 0 && alignment <= MaxAlignment);
+        assert(size <= std::numeric_limits<uint32_t>::max());
+
+        std::unique_lock lock(Mtx);
+        Generation& gen = GetGeneration(lifetime);
+
+        uintptr_t pos = 0;
+        if (gen.Pages)
+        {
+            pos = AlignUp(reinterpret_cast<uintptr_t>(gen.Pages->Data()) + gen.Pages->Used, alignment);
+        }
+
+        if (!gen.Pages || (pos + size) > reinterpret_cast<uintptr_t>(gen.Pages->Data()) + gen.Pages->Capacity)
+        {
+            Page* page = NewPage(size + alignment);
+            page->Next = gen.Pages;
+            gen.Pages = page;
+            pos = AlignUp(reinterpret_cast<uintptr_t>(page->Data()), alignment);
+        }
+
+        gen.Pages->Used = static_cast<size_t>(pos + size - reinterpret_cast<uintptr_t>(gen.Pages->Data()));
+        if (lifetime.NumFrames == 0)
+        {
+            gen.LiveCount++;
+            // Once a persistent generation needs more than a page, we start a new one, so generations don't stay
+            // alive forever because of a single allocation.
+            if (gen.Pages->Next)
+            {
+                gen.Open = false;
+            }
+        }
+
+        Ref ref;
+        ref.Ptr = reinterpret_cast<uint8_t*>(pos);
+        ref.Size = static_cast<uint32_t>(size);
+        ref.GenerationId = gen.Id;
+        return ref;
+    }
+
+    /*!
+     * Allocates and copies `count` elements
+     */
+    template<typename T>
+    Ref Push(const T* data, size_t count, Lifetime lifetime)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Ref ref = Alloc(count * sizeof(T), alignof(T), lifetime);
+        memcpy(ref.Ptr, data, count * sizeof(T));
+        return ref;
+    }
+
+    /*!
+     * Allocates a null terminated copy of the string
+     */
+    Ref PushString(std::string_view str, Lifetime lifetime)
+    {
+        Ref ref = Alloc(str.size() + 1, 1, lifetime);
+        memcpy(ref.Ptr, str.data(), str.size());
+        ref.Ptr[str.size()] = 0;
+        return ref;
+    }
+
+    /*!
+     * Releases an allocation done with Lifetime::UntilReleased.
+     * The memory is only reclaimed once the render thread can't be using it anymore.
+     */
+    void Release(Ref ref)
+    {
+        if (!ref.IsSet())
+        {
+            return;
+        }
+
+        std::unique_lock lock(Mtx);
+        for (Generation& gen : Generations)
+        {
+            if (gen.Id == ref.GenerationId)
+            {
+                assert(gen.Persistent && gen.LiveCount > 0);
+                gen.LiveCount--;
+                gen.LastUseFrame = Frame;
+                return;
+            }
+        }
+
+        assert(false && "Ref doesn't belong to a live generation");
+    }
+
+    /*!
+     * Gives an allocation's data pointer, cast to the specified type
+     */
+    template<typename T>
+    static T* At(Ref ref)
+    {
+        assert((reinterpret_cast<uintptr_t>(ref.Ptr) % alignof(T)) == 0);
+        return reinterpret_cast<T*>(ref.Ptr);
+    }
+
+    /*!
+     * Needs to be called once per frame, when the queue sets are swapped (and thus no other thread is using the arena).
+     * Frees all the generations the render thread is done with.
+     */
+    void AdvanceFrame()
+    {
+        std::unique_lock lock(Mtx);
+        Frame++;
+
+        for (size_t i = 0; i < Generations.size();)
+        {
+            Generation& gen = Generations[i];
+
+            // Data used by commands queued in frame N is consumed by the render thread during frame N+1, so by the
+            // time we get to N+2 it's safe to free.
+            bool expired = (Frame >= gen.LastUseFrame + 2) && (!gen.Persistent || (gen.LiveCount == 0 && !gen.Open));
+            if (expired)
+            {
+                FreePages(gen.Pages);
+                Generations[i] = Generations.back();
+                Generations.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    /*!
+     * Number of bytes currently held in pages (in use or not), excluding the free list
+     */
+    size_t GetReservedBytes() const
+    {
+        std::unique_lock lock(Mtx);
+        size_t total = 0;
+        for (const Generation& gen : Generations)
+        {
+            for (Page* page = gen.Pages; page; page = page->Next)
+            {
+                total += page->Capacity;
+            }
+        }
+        return total;
+    }
+
+  private:
+
+    inline static constexpr size_t MaxAlignment = 64;
+
+    static uintptr_t AlignUp(uintptr_t a, size_t b)
+    {
+        return (a + b - 1) & ~(static_cast<uintptr_t>(b) - 1);
+    }
+
+    struct Page
+    {
+        Page* Next = nullptr;
+        size_t Capacity = 0;
+        size_t Used = 0;
+
+        uint8_t* Data()
+        {
+            return reinterpret_cast<uint8_t*>(this) + HeaderSize;
+        }
+    };
+
+    inline static constexpr size_t HeaderSize = sizeof(Page);
+
+    struct Generation
+    {
+        uint32_t Id = 0;
+        bool Persistent = false;
+
+        // Persistent generations only accept new allocations while open
+        bool Open = true;
+
+        // Last frame the generation's data can be used by queued commands
+        uint64_t LastUseFrame = 0;
+
+        // Number of unreleased allocations (persistent generations only)
+        uint32_t LiveCount = 0;
+
+        Page* Pages = nullptr;
+    };
+
+    Generation& GetGeneration(Lifetime lifetime)
+    {
+        bool persistent = lifetime.NumFrames == 0;
+        uint64_t lastUseFrame = persistent ? Frame : Frame + lifetime.NumFrames - 1;
+
+        // The generations we want are almost always the most recent ones, so search backwards
+        for (size_t i = Generations.size(); i--;)
+        {
+            Generation& gen = Generations[i];
+            if (persistent ? (gen.Persistent && gen.Open) : (!gen.Persistent && gen.LastUseFrame == lastUseFrame))
+            {
+                return gen;
+            }
+        }
+
+        Generation& gen = Generations.emplace_back();
+        gen.Id = ++GenerationCounter;
+        gen.Persistent = persistent;
+        gen.LastUseFrame = lastUseFrame;
+        return gen;
+    }
+
+    Page* NewPage(size_t minCapacity)
+    {
+        if (minCapacity <= PageSize && FreeList)
+        {
+            Page* page = FreeList;
+            FreeList = page->Next;
+            page->Next = nullptr;
+            page->Used = 0;
+            return page;
+        }
+
+        // Pages don't need to be aligned, since Alloc aligns the allocations themselves, and a new page always
+        // has room for the padding.
+        size_t capacity = minCapacity <= PageSize ? PageSize : minCapacity;
+        Page* page = new (malloc(HeaderSize + capacity)) Page();
+        page->Capacity = capacity;
+        return page;
+    }
+
+    void FreePages(Page* page)
+    {
+        while (page)
+        {
+            Page* next = page->Next;
+            // Only standard sized pages are recycled
+            if (page->Capacity == PageSize)
+            {
+                page->Next = FreeList;
+                FreeList = page;
+            }
+            else
+            {
+                free(page);
+            }
+            page = next;
+        }
+    }
+
+    mutable std::mutex Mtx;
+    size_t PageSize;
+    uint64_t Frame = 0;
+    uint32_t GenerationCounter = 0;
+    std::vector<Generation> Generations;
+    Page* FreeList = nullptr;
+};
@@ -0,0 +1,148 @@
+/*******************************************************************************************
+*
+*   Compact encodings for command payloads.
+*
+*   Command data is written by one thread and read by another, so the fewer bytes it takes, the less cache traffic
+*   between the cores. These trade some precision for size:
+*   - Half floats (16 bits), for things like sizes and position deltas
+*   - Snorm16, for values in [-1, 1], such as normalized axes
+*   - 16 bits angles, in fractions of a full turn
+*
+*   Decoding is branch free, so loops decoding whole columns can be vectorized by the compiler.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace Quantize
+{
+    /*!
+     * Largest finite half float. Anything bigger is clamped to it, so infinities are never encoded.
+     */
+    inline constexpr float HalfMax = 65504.0f;
+
+    /*!
+     * Float to half float, rounding to nearest even.
+     * Values out of range are clamped, and NaNs are not supported.
+     */
+    inline uint16_t FloatToHalf(float value)
+    {
+        uint32_t f = std::bit_cast<uint32_t>(value);
+        const uint32_t sign = f & 0x80000000u;
+        f ^= sign;
+
+        uint32_t h;
+        if (f > 0x477fe000u)  // Over HalfMax
+        {
+            h = 0x7bffu;
+        }
+        else if (f < 0x38800000u)  // Too small for a normal half, so it's a subnormal or 0
+        {
+            // Adding 0.5 lines up the bits so the mantissa is the subnormal, and the FPU does the rounding
+            h = std::bit_cast<uint32_t>(std::bit_cast<float>(f) + 0.5f) - 0x3f000000u;
+        }
+        else
+        {
+            const uint32_t mantissaOdd = (f >> 13) & 1;
+            // Rebias the exponent, and round to nearest even
+            f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu;
+            f += mantissaOdd;
+            h = f >> 13;
+        }
+
+        return static_cast<uint16_t>(h | (sign >> 16));
+    }
+
+    /*!
+     * Half float to float.
+     * Handles normals and subnormals, which is all FloatToHalf produces.
+     */
+    inline float HalfToFloat(uint16_t h)
+    {
+        // Move the exponent and mantissa into place, and rebias by multiplying with 2^112, which also normalizes subnormals
+        const float magnitude = std::bit_cast<float>(static_cast<uint32_t>(h & 0x7fffu) << 13) * 0x1p112f;
+        return std::bit_cast<float>(std::bit_cast<uint32_t>(magnitude) | (static_cast<uint32_t>(h & 0x8000u) << 16));
+    }
+
+    inline int16_t FloatToSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline float Snorm16ToFloat(int16_t value)
+    {
+        // -32768 is never encoded, so no need to clamp
+        return static_cast<float>(value) * (1.0f / 32767.0f);
+    }
+
+    /*!
+     * Fixed point with `scale` steps per unit (a power of 2, so decoding is exact), and a precision of half a step.
+     * Values out of range are clamped, so callers that care need to check with FitsFixed16 first.
+     */
+    inline int16_t FloatToFixed16(float value, float scale)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value * scale, -32767.0f, 32767.0f)));
+    }
+
+    inline bool FitsFixed16(float value, float scale)
+    {
+        return std::fabs(value * scale) <= 32767.0f;
+    }
+
+    inline float Fixed16ToFloat(int16_t value, float scale)
+    {
+        return static_cast<float>(value) * (1.0f / scale);
+    }
+
+    /*!
+     * Angle in degrees, wrapped to a full turn, with a precision of 360/65536 degrees
+     */
+    inline uint16_t DegreesToAngle16(float degrees)
+    {
+        const float turns = degrees * (1.0f / 360.0f);
+        return static_cast<uint16_t>(static_cast<int32_t>(std::lround((turns - std::floor(turns)) * 65536.0f)) & 0xffff);
+    }
+
+    inline float Angle16ToDegrees(uint16_t angle)
+    {
+        return static_cast<float>(angle) * (360.0f / 65536.0f);
+    }
+
+    /*!
+     * Decodes `count` half floats. Meant for whole columns, so the compiler can vectorize it.
+     */
+    inline void HalfToFloat(const uint16_t* src, float* dst, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            dst[i] = HalfToFloat(src[i]);
+        }
+    }
+
+    inline void Snorm16ToFloat(const int16_t* src, float* dst, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            dst[i] = Snorm16ToFloat(src[i]);
+        }
+    }
+
+    inline void Angle16ToDegrees(const uint16_t* src, float* dst, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            dst[i] = Angle16ToDegrees(src[i]);
+        }
+    }
+
+} // namespace Quantize
@@ -0,0 +1,233 @@
+/*******************************************************************************************
+*
+*   Allocators for the memory backing the command queues.
+*
+*   A queue asks its allocator for one block, and for a new one whenever it grows or shrinks. Which allocator works
+*   best depends on the platform and on how the queue is used, so it can be picked per queue (e.g per render group):
+*   - SystemQueueAllocator: The C runtime's aligned malloc. The default.
+*   - PagePoolQueueAllocator: Keeps freed blocks around, to be reused by any queue sharing the pool. This avoids going
+*     to the system allocator when queues grow and shrink in turns (e.g secondaries).
+*   - VirtualMemoryQueueAllocator: Reserves address space upfront and commits pages as needed, so a queue grows in
+*     place, without copying, and shrinking gives the pages back to the OS.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+    #include <malloc.h>
+#endif
+
+namespace details
+{
+    /**
+     * Returns `a` rounded up to a multiple of `b`
+     */
+    template<typename T>
+    static constexpr T RoundUpToMultipleOf(T a, T b)
+    {
+        // If `b` is 0, then we don't do any alignment
+        if (b == 0)
+        {
+            return a;
+        }
+
+        // Integer division trick to round up `a` to a multiple of `b`
+        //
+        return ((a + b - 1) / b) * b;
+    }
+
+    /*!
+     * Alignment of the queues' memory, and therefore the biggest alignment the queues can honor for what is pushed.
+     * A cache line, which also covers SSE/AVX types.
+     */
+    inline constexpr std::size_t MaxAlignment = 64;
+
+    inline void* AlignedAlloc(std::size_t size)
+    {
+        // Windows' CRT doesn't have aligned_alloc, with any compiler (MinGW included)
+#if defined(_WIN32)
+        return _aligned_malloc(size, MaxAlignment);
+#else
+        // aligned_alloc requires the size to be a multiple of the alignment
+        return aligned_alloc(MaxAlignment, RoundUpToMultipleOf(size, MaxAlignment));
+#endif
+    }
+
+    inline void AlignedFree(void* ptr)
+    {
+#if defined(_WIN32)
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+
+} // namespace details
+
+/*!
+ * Interface for the allocators.
+ * Blocks need to be aligned to details::MaxAlignment. Allocators can be shared by queues used from different threads, so
+ * they need to be thread safe.
+ */
+class QueueAllocator
+{
+  public:
+    virtual ~QueueAllocator() = default;
+
+    /*!
+     * Returns a block of at least `bytes`, or nullptr if it can't.
+     */
+    virtual void* Allocate(size_t bytes) = 0;
+
+    /*!
+     * Returns the size of the block Allocate(bytes) would return. Allocators that round sizes up report it here, so
+     * the queues can use (and charge their budgets for) the whole block.
+     */
+    virtual size_t GetUsableSize(size_t bytes) const
+    {
+        return bytes;
+    }
+
+    /*!
+     * Frees a block. `bytes` is the size it was allocated (or last resized) with.
+     */
+    virtual void Free(void* ptr, size_t bytes) = 0;
+
+    /*!
+     * Tries to resize a block in place, keeping its contents. Returns false if not supported or not possible, in which
+     * case the queue allocates a new block and copies the data over.
+     */
+    virtual bool TryResize([[maybe_unused]] void* ptr, [[maybe_unused]] size_t oldBytes, [[maybe_unused]] size_t newBytes)
+    {
+        return false;
+    }
+
+    /*!
+     * Allocator used by queues that don't set one.
+     */
+    static QueueAllocator& GetDefault();
+};
+
+/*!
+ * Allocator for CommandQueue that forwards to a QueueAllocator picked at runtime (nullptr for QueueAllocator::GetDefault()).
+ */
+class QueueAllocatorRef
+{
+  public:
+    QueueAllocatorRef(QueueAllocator* allocator = nullptr)
+        : Allocator(allocator ? allocator : &QueueAllocator::GetDefault())
+    {
+    }
+
+    void* Allocate(size_t bytes)
+    {
+        return Allocator->Allocate(bytes);
+    }
+
+    size_t GetUsableSize(size_t bytes) const
+    {
+        return Allocator->GetUsableSize(bytes);
+    }
+
+    void Free(void* ptr, size_t bytes)
+    {
+        Allocator->Free(ptr, bytes);
+    }
+
+    bool TryResize(void* ptr, size_t oldBytes, size_t newBytes)
+    {
+        return Allocator->TryResize(ptr, oldBytes, newBytes);
+    }
+
+    bool operator==(const QueueAllocatorRef& other) const = default;
+
+  private:
+    QueueAllocator* Allocator;
+};
+
+class SystemQueueAllocator : public QueueAllocator
+{
+  public:
+    void* Allocate(size_t bytes) override
+    {
+        return details::AlignedAlloc(bytes);
+    }
+
+    void Free(void* ptr, [[maybe_unused]] size_t bytes) override
+    {
+        details::AlignedFree(ptr);
+    }
+};
+
+/*!
+ * Rounds blocks up to a power of 2 (of at least a page), and keeps freed blocks in a list per size, so that queues
+ * sharing the pool can reuse each other's memory.
+ */
+class PagePoolQueueAllocator : public QueueAllocator
+{
+  public:
+    /*!
+     * \param maxCachedBytes
+     *  How much freed memory the pool can hold on to. Blocks freed over that go back to the system.
+     */
+    explicit PagePoolQueueAllocator(size_t maxCachedBytes = 64 * 1024 * 1024)
+        : MaxCachedBytes(maxCachedBytes)
+    {
+    }
+
+    ~PagePoolQueueAllocator() override;
+
+    void* Allocate(size_t bytes) override;
+    size_t GetUsableSize(size_t bytes) const override;
+    void Free(void* ptr, size_t bytes) override;
+
+    size_t GetCachedBytes() const
+    {
+        std::lock_guard lock(Mtx);
+        return CachedBytes;
+    }
+
+  private:
+    inline static constexpr size_t MinBlockSize = 4096;
+    inline static constexpr int NumSizeClasses = 48;
+
+    static int GetSizeClass(size_t bytes);
+
+    mutable std::mutex Mtx;
+    std::vector<void*> FreeBlocks[NumSizeClasses];
+    size_t CachedBytes = 0;
+    size_t MaxCachedBytes;
+};
+
+/*!
+ * Each block reserves `reserveBytes` of address space, but only the pages in use are committed. Growing and shrinking
+ * happen in place, by committing or decommitting pages.
+ * Blocks bigger than the reservation can't be allocated.
+ */
+class VirtualMemoryQueueAllocator : public QueueAllocator
+{
+  public:
+    explicit VirtualMemoryQueueAllocator(size_t reserveBytes = size_t(1) << 30);
+
+    void* Allocate(size_t bytes) override;
+    void Free(void* ptr, size_t bytes) override;
+    bool TryResize(void* ptr, size_t oldBytes, size_t newBytes) override;
+
+  private:
+    bool Commit(void* ptr, size_t fromBytes, size_t toBytes);
+    void Decommit(void* ptr, size_t fromBytes, size_t toBytes);
+
+    size_t PageSize;
+    size_t ReserveBytes;
+};
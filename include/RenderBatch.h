@@ -0,0 +1,113 @@
+/*******************************************************************************************
+*
+*   rlgl render batch, sized from the vertex counts measured in previous frames.
+*
+*   raylib's default batch has a fixed capacity, and gets flushed (uploaded + drawn) whenever it
+*   fills up. With thousands of cubes that means many intermediate flushes per frame.
+*   A RenderBatch owns its own rlRenderBatch, sized to fit what was drawn in the last frames,
+*   with multiple vertex buffers that rlgl rotates through on each flush, so uploading to a
+*   buffer doesn't need to wait for the GPU to finish with the previous draw from it.
+*
+*   Everything here needs to be used from the render thread only.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "rlgl.h"
+
+#include <cstdint>
+
+class RenderBatch
+{
+  public:
+
+    struct Stats
+    {
+        // Vertices drawn (as reported with Reserve)
+        uint32_t Vertices = 0;
+        // Number of times the batch was flushed (including the final one)
+        uint32_t Flushes = 0;
+        // Capacity of each of the batch's vertex buffers, in vertices
+        uint32_t Capacity = 0;
+    };
+
+    /*!
+     * \param numBuffers
+     *      Number of vertex buffers rlgl rotates through.
+     */
+    explicit RenderBatch(int numBuffers = 2)
+        : NumBuffers(numBuffers)
+    {
+    }
+
+    ~RenderBatch();
+
+    RenderBatch(const RenderBatch&) = delete;
+    RenderBatch& operator=(const RenderBatch&) = delete;
+
+    /*!
+     * Releases the GPU resources. Needs to be called before the window is closed.
+     */
+    void Unload();
+
+    /*!
+     * Makes this the active rlgl batch, resizing it first if the last frames needed a different size.
+     */
+    void Begin();
+
+    /*!
+     * Flushes the batch, and restores rlgl's default batch.
+     */
+    void End();
+
+    /*!
+     * Stats for the last Begin/End
+     */
+    const Stats& GetStats() const
+    {
+        return LastStats;
+    }
+
+    /*!
+     * Makes sure the active batch has room for `numVertices`, flushing it if necessary, and accounts for them in the stats.
+     * Any code emitting vertices through rlgl should call this first, with up to a few thousand vertices at a time.
+     * If there is no active RenderBatch, it just checks rlgl's default batch.
+     */
+    static void Reserve(int numVertices);
+
+  private:
+
+    // rlgl doesn't tell us when it flushes a batch on its own (e.g when it runs out of draw calls), but it resets the
+    // batch's depth when it does, so that's how we detect it.
+    void CheckFlush()
+    {
+        if (Batch.currentDepth < LastDepth)
+        {
+            CurrStats.Flushes++;
+        }
+        LastDepth = Batch.currentDepth;
+    }
+
+    inline static RenderBatch* Active = nullptr;
+
+    // Number of frames we look back at to size the batch
+    inline static constexpr int HistorySize = 30;
+
+    rlRenderBatch Batch = {};
+    bool Loaded = false;
+    int NumBuffers;
+    int NumElements = 0;
+    float LastDepth = 0;
+
+    uint32_t History[HistorySize] = {};
+    int HistoryIndex = 0;
+
+    Stats CurrStats;
+    Stats LastStats;
+};
@@ -0,0 +1,46 @@
+/*******************************************************************************************
+*
+*   Render passes that can be added with RenderQueue::AddPass.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "RenderQueue.h"
+
+/*!
+ * Drops the commands with bounds that none of the group's views can see. That includes the execution of blocks whose
+ * commands all have bounds (e.g a secondary with DrawCubesEx).
+ * Render culls each view as it renders it, but commands no view can see are then tested once per view, on the render
+ * thread. This tests them once, on a worker. Only for 3D groups where all views cull.
+ */
+class CullRenderPass : public RenderPass
+{
+  public:
+    const char* GetName() const override
+    {
+        return "Cull";
+    }
+
+    bool Reorders() const override
+    {
+        return false;
+    }
+
+    bool Drops() const override
+    {
+        return true;
+    }
+
+    bool AppliesTo(const RenderGroupDesc& desc) const override
+    {
+        return desc.CameraMode == RenderCameraMode::Mode3D;
+    }
+
+    void Run(RenderPassContext& ctx) override;
+};
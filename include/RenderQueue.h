@@ -9,9 +9,22 @@
 *
 ********************************************************************************************/
 
+#pragma once
+
 #include "RenderCmdQueue.h"
+#include "CommandColumns.h"
+#include "CubeColumns.h"
+#include "PersistentArena.h"
+#include "StringInterner.h"
+#include "TextLayout.h"
+#include "UIBatcher.h"
+#include "WorldGeometry.h"
+#include "RenderBatch.h"
+#include "CameraSnapshot.h"
+#include "WorkerPool.h"
 
 #include "raylib.h"
+#include "rlgl.h"
 
 #include <cstdint>
 #include <type_traits>
@@ -19,12 +32,359 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string_view>
+#include <atomic>
+#include <chrono>
+
+#if __has_include(<format>)
+    #include <format>
+#else
+    #error This sample requires support for std::format
+#endif
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+/*!
+ * Identifies a render group. Each group has its own command queue, and they are rendered in order of priority.
+ * World and UI are always available. Other groups (e.g debug draw, minimap, shadows) can be added with
+ * RenderQueue::AddGroup.
+ */
+struct RenderGroup
+{
+    uint32_t Index;
+
+    static const RenderGroup World;
+    static const RenderGroup UI;
+
+    bool operator==(const RenderGroup& other) const
+    {
+        return Index == other.Index;
+    }
+};
+
+inline constexpr RenderGroup RenderGroup::World{0};
+inline constexpr RenderGroup RenderGroup::UI{1};
+
+enum class RenderCameraMode
+{
+    // Draws with whatever transform is set (e.g screen space)
+    None,
+    // BeginMode2D with the group's camera
+    Mode2D,
+    // BeginMode3D with the group's camera
+    Mode3D
+};
+
+/*!
+ * How the commands queued directly to a group are reordered before being rendered.
+ * Only commands that carry sort info (e.g DrawCube) are reordered. Any other command (e.g the execution of a block)
+ * stays where it was queued, and acts as a barrier, so commands are never moved across it.
+ */
+enum class RenderSortMode
+{
+    // Submission order
+    None,
+    // By render state (texture + primitive), to minimize rlgl draw calls
+    State,
+    // Closest to the camera first, to reduce overdraw
+    FrontToBack,
+    // Furthest from the camera first, for transparency
+    BackToFront,
+    // By command type, so each type's commands run together (see CommandQueue::CallAllGrouped). Unlike the other modes,
+    // all commands are reordered, so it's only for groups where the order across command types doesn't matter.
+    Type
+};
+
+/*!
+ * How important it is to render something when the render thread is over its time budget (see RenderQueue::SetRenderBudget).
+ * The least important things are dropped first.
+ */
+enum class RenderImportance : uint8_t
+{
+    // Never dropped (e.g UI)
+    Required,
+    High,
+    Normal,
+    // First to be dropped (e.g debug draw, far LODs)
+    Low
+};
+
+struct RenderGroupDesc
+{
+    std::string Name;
+
+    // Groups are rendered by ascending priority. Groups with the same priority are rendered in the order they were added.
+    int Priority = 0;
+
+    RenderCameraMode CameraMode = RenderCameraMode::None;
+    RenderSortMode SortMode = RenderSortMode::None;
+
+    // If set (id != 0), the group renders to this texture instead of the screen
+    RenderTexture2D Target = {};
+
+    // If true, the target (or the screen) is cleared with ClearColor before the group is rendered
+    bool Clear = false;
+    Color ClearColor = BLANK;
+
+    // Commands in the group are never more important than this, even if queued with a more important RenderImportance
+    RenderImportance Importance = RenderImportance::Normal;
+
+    // Where the memory of the group's queues comes from. nullptr uses the one set with RenderQueue::SetQueueAllocator.
+    // Needs to outlive the RenderQueue.
+    QueueAllocator* Allocator = nullptr;
+};
+
+/*!
+ * A camera + viewport a 3D group is rendered with. A group with multiple views replays the same recorded commands once per
+ * view (e.g split-screen, minimap), so the recording cost doesn't depend on the number of views.
+ */
+struct RenderView
+{
+    Camera3D Camera = {};
+
+    // Area of the target to render to, in pixels. If width or height are 0, it uses the whole target.
+    Rectangle Viewport = {};
+
+    // Skips commands and blocks whose bounds are fully outside the view's frustum
+    bool Cull = true;
+
+    // If true, the viewport is cleared with ClearColor before rendering the view
+    bool Clear = false;
+    Color ClearColor = BLANK;
+};
+
+struct RenderGroupStats
+{
+    RenderBatch::Stats Batch;
+    // Number of commands queued directly to the group
+    uint32_t NumCommands = 0;
+    // Number of views the commands were replayed for
+    uint32_t NumViews = 0;
+    // Commands and blocks skipped by culling, across all views
+    uint32_t NumCulled = 0;
+    // Commands and blocks skipped because the render thread was over budget, across all views
+    uint32_t NumDropped = 0;
+    // Pushes to the group's queue that failed due to the memory budget (see RenderQueue::SetMemoryBudget)
+    uint32_t NumFailedPushes = 0;
+    // Time the render thread spent on the group
+    float RenderMs = 0;
+};
+
+struct RenderMemoryStats
+{
+    // Capacity of all the frame's queues (groups and secondaries)
+    size_t Capacity = 0;
+    // Pushes that failed due to the memory budget, in all the frame's queues
+    uint32_t NumFailedPushes = 0;
+    // Bytes written to the frame's queues and command columns
+    size_t UsedBytes = 0;
+};
+
+/*!
+ * A command queued directly to a group, as seen by the render passes
+ */
+struct RenderPassCmd
+{
+    RenderCmdQueue::Ref Cmd;
+
+    // Bounding sphere and sort info. Only commands queued with them (e.g DrawCube) have it. Others (e.g the execution of a
+    // block) stay at RenderImportance::Required, so they are only dropped along with their group.
+    bool HasBounds = false;
+    Vector3 Position = {};
+    float Radius = 0;
+    uint32_t StateKey = 0;
+    RenderImportance Importance = RenderImportance::Required;
+
+    // The execution of a block (ExecuteBlock or ExecuteSecondary). If all the block's commands have bounds, HasBounds is
+    // set, with a sphere around all of them, so the block can be culled. The sort modes never move blocks though, since
+    // they can contain anything.
+    bool IsBlock = false;
+};
+
+struct RenderPassContext
+{
+    RenderGroup Group;
+    const RenderGroupDesc& Desc;
+
+    // The group's queue. Passes can push new commands to it (e.g a merged draw, or a lower LOD), and reference them in Cmds.
+    RenderCmdQueue& Q;
+
+    // Views of a 3D group, and the camera snapshots they are rendered with, in the same order
+    std::span<const RenderView> Views;
+    std::span<const CameraSnapshot> Cameras;
+
+    // The commands the group runs, in order
+    std::vector<RenderPassCmd>& Cmds;
+};
+
+/*!
+ * A transformation of the commands queued directly to a group (culling, sorting, merging, LOD substitution,
+ * validation...). See RenderQueue::AddPass.
+ *
+ * Passes run on worker threads, one job per group, so Run can be called for different groups at the same time, and
+ * shouldn't touch anything other than the context it's given.
+ */
+class RenderPass
+{
+  public:
+    virtual ~RenderPass() = default;
+
+    virtual const char* GetName() const = 0;
+
+    // If true, the pass can change the order of the context's Cmds
+    virtual bool Reorders() const = 0;
+
+    // If true, the pass can remove entries from the context's Cmds, or replace them with other commands
+    virtual bool Drops() const = 0;
+
+    // Returns true if the pass should run for the group
+    virtual bool AppliesTo([[maybe_unused]] const RenderGroupDesc& desc) const
+    {
+        return true;
+    }
+
+    virtual void Run(RenderPassContext& ctx) = 0;
+};
+
+struct RenderPassStats
+{
+    // Time spent in the pass, across all groups
+    float Ms = 0;
+    // Number of groups the pass ran for
+    uint32_t NumGroups = 0;
+    // Entries the pass removed from the groups' commands
+    uint32_t NumDropped = 0;
+};
+
+/*!
+ * A block of render commands that is recorded once, and can then be executed any number of times with
+ * RenderQueue::ExecuteBlock, without copying the commands again.
+ *
+ * Blocks are immutable once recorded, and are shared with the queue sets through a shared_ptr, so a block stays
+ * alive for as long as any queue set still references it, even if the user code drops it.
+ * Calling Invalidate makes any pending or future executions a no-op, which is how the user code can retire a block
+ * that might still be referenced by the set the render thread is processing.
+ */
+class RenderCmdBlock
+{
+  public:
+
+    /*!
+     * Marks the block as no longer valid. Any queued execution of this block will be skipped.
+     * Can be called from any thread.
+     */
+    void Invalidate()
+    {
+        Valid = false;
+    }
+
+    bool IsValid() const
+    {
+        return Valid;
+    }
+
+    /*!
+     * Makes room for `bytes` of commands upfront, so recording doesn't need to grow the block.
+     */
+    bool Reserve(uint32_t bytes)
+    {
+        return Q.Reserve(bytes);
+    }
+
+    /*!
+     * Empties the block, keeping its memory, so it can be recorded again.
+     * Only for blocks that no queue set references (e.g: never executed), since it breaks the immutability the queue
+     * sets rely on.
+     */
+    void Clear()
+    {
+        Q.Clear();
+        Blocks.clear();
+        BoundsMin = BoundsMax = {};
+        NumBounded = 0;
+    }
+
+  private:
+    friend class RenderQueue;
+
+    RenderCmdQueue Q;
+
+    // Blocks executed from inside this block, so they live as long as this one does.
+    std::vector<std::shared_ptr<RenderCmdBlock>> Blocks;
+
+    // Bounds of the commands that have them. The block can only be culled if all its commands have bounds.
+    Vector3 BoundsMin = {};
+    Vector3 BoundsMax = {};
+    uint32_t NumBounded = 0;
 
-enum class RenderGroup
+    // Set for secondaries, which only live for the frame they are recorded in, unlike blocks made with RecordBlock
+    bool FrameScoped = false;
+
+    std::atomic<bool> Valid = true;
+};
+
+/*!
+ * Cubes published by the logic side for a frame, one array per field. Commands then reference ranges of it (see
+ * RenderQueue::DrawCubeRange), so the queues only carry "draw rows [begin, end) of this snapshot", instead of a copy of
+ * every cube.
+ *
+ * Snapshots are pooled by the RenderQueue. Get one with RenderQueue::AcquireCubeSnapshot, fill it from one thread, and
+ * Publish it, after which it's immutable, and can be referenced from any thread.
+ * Releasing it with RenderQueue::ReleaseCubeSnapshot doesn't make it available straight away. Each frame is an epoch,
+ * and a snapshot remembers the last epoch it was referenced in, so it's only reused once the render thread is done with
+ * that epoch's queue set.
+ */
+class CubeSnapshot
 {
-    World,
-    UI,
-    MAX
+  public:
+    void Add(const CubeDesc& cube)
+    {
+        assert(!Published);
+        Columns.Append(cube.Position, cube.RotationAxis, cube.Degrees, {cube.Width, cube.Height, cube.Length}, cube.CubeColor, cube.WireColor);
+    }
+
+    /*!
+     * Makes the snapshot immutable, so ranges of it can be drawn
+     */
+    void Publish()
+    {
+        Published = true;
+    }
+
+    bool IsPublished() const
+    {
+        return Published;
+    }
+
+    uint32_t GetSize() const
+    {
+        return Columns.GetSize();
+    }
+
+  private:
+    friend class RenderQueue;
+
+    enum Column
+    {
+        Position,
+        RotationAxis,
+        Degrees,
+        Size,
+        CubeColor,
+        WiresColor
+    };
+
+    CommandColumns<Vector3, Vector3, float, Vector3, Color, Color> Columns;
+    bool Published = false;
+
+    // Held by the user code, from AcquireCubeSnapshot until ReleaseCubeSnapshot. Protected by the pool's mutex.
+    bool Acquired = false;
+
+    // Last epoch a range of it was queued in. Not part of the data, so it can change after the snapshot is published.
+    mutable std::atomic<uint64_t> LastUsedEpoch = 0;
 };
 
 /*!
@@ -42,6 +402,10 @@ class RenderQueue
         Instance = this;
         LogicSet = &QSet[0];
         RenderSet = &QSet[1];
+
+        [[maybe_unused]] RenderGroup world = AddGroup({.Name = "World", .Priority = 0, .CameraMode = RenderCameraMode::Mode3D});
+        [[maybe_unused]] RenderGroup ui = AddGroup({.Name = "UI", .Priority = 100, .Importance = RenderImportance::Required});
+        assert(world == RenderGroup::World && ui == RenderGroup::UI);
     }
 
     static RenderQueue& Get()
@@ -53,8 +417,334 @@ class RenderQueue
     void SwapQueues()
     {
         std::swap(LogicSet, RenderSet);
+        Epoch++;
+        Arena.AdvanceFrame();
+
+        PublishedDropLevel = DropLevel;
+        PublishedMemoryStats = MemoryStats;
+        for (size_t i = 0; i < Groups.size(); i++)
+        {
+            // Publish the render stats, so the logic threads can read them during the next frame
+            Groups[i]->PublishedStats = Groups[i]->Stats;
+
+            // Cameras and views carry over to the next frame, unless the logic side sets them again
+            LogicSet->Groups[i]->Cam2D = RenderSet->Groups[i]->Cam2D;
+            LogicSet->Groups[i]->Views = RenderSet->Groups[i]->Views;
+        }
+
+        PublishedPassStats = PassStats;
+        if (PassWorkers)
+        {
+            // The passes work on the set while this thread does whatever else it needs before rendering it
+            PassWorkers->ParallelForAsync(static_cast<int>(Groups.size()), PassJob);
+        }
+    }
+
+    /*!
+     * Releases any GPU resources. Needs to be called from the render thread before the window is closed.
+     */
+    void Unload()
+    {
+        if (PassWorkers)
+        {
+            PassWorkers->Wait();
+        }
+
+        for (std::unique_ptr<GroupData>& group : Groups)
+        {
+            group->Batch.Unload();
+        }
+    }
+
+    /*!
+     * Adds a render group.
+     * Needs to be called before the logic threads start, like AddFont.
+     */
+    RenderGroup AddGroup(const RenderGroupDesc& desc);
+
+    /*!
+     * Changes the settings of an existing group (e.g to sort the World group).
+     * Needs to be called before the logic threads start, like AddFont.
+     */
+    void SetGroupDesc(RenderGroup group, const RenderGroupDesc& desc);
+
+    static const RenderGroupDesc& GetGroupDesc(RenderGroup group)
+    {
+        return Get().Groups[group.Index]->Desc;
+    }
+
+    /*!
+     * Stats for the specified group, for the last rendered frame.
+     * Safe to call from the logic threads.
+     */
+    static const RenderGroupStats& GetGroupStats(RenderGroup group)
+    {
+        return Get().Groups[group.Index]->PublishedStats;
+    }
+
+    /*!
+     * Bounds the memory used by the queues the logic side records into each frame. 0 means no limit.
+     * \param setBytes Total capacity of all the queues of a frame (groups and secondaries)
+     * \param queueBytes Capacity of any single one of those queues
+     *
+     * When a queue can't grow, pushes to it fail, and the commands are simply not queued. Once a push fails, the queue
+     * stays failed until the end of the frame, so commands that depend on each other are never partially queued.
+     * Queues also shrink sooner than without a budget, so a spike in one doesn't hold on to the budget for long.
+     * Needs to be called before the logic threads start, like AddFont.
+     */
+    void SetMemoryBudget(size_t setBytes, uint32_t queueBytes);
+
+    /*!
+     * Enables quantizing command data where it's supported (DrawCubeEx): fixed point position deltas, half float sizes,
+     * snorm16 axes and 16 bits angles. This reduces how many bytes go from the logic threads to the render thread, at the
+     * cost of some precision (positions are within 1/128 of the real ones).
+     * Needs to be called before the logic threads start, like AddFont.
+     */
+    void SetCompactCommands(bool enabled)
+    {
+        CompactCommands = enabled;
+    }
+
+    /*!
+     * Sets where the memory of the queues comes from (nullptr for QueueAllocator::GetDefault()), for groups that don't
+     * set their own, and for secondaries. The allocator needs to outlive the RenderQueue.
+     * Needs to be called before the logic threads start, like AddFont.
+     */
+    void SetQueueAllocator(QueueAllocator* allocator);
+
+    /*!
+     * Saves the capacity each queue is predicted to need (see RenderCmdQueue::SizingPolicy), so the next run can size
+     * the queues upfront with LoadQueueProfile.
+     * Needs to be called when the logic threads are not running (e.g at shutdown).
+     */
+    bool SaveQueueProfile(const char* fileName) const;
+
+    /*!
+     * Sizes the queues of both sets from a profile saved with SaveQueueProfile, and prefaults their memory, so the first
+     * frames don't pay for growing them. Groups are matched by name, and anything the profile doesn't mention is left
+     * as-is. Returns false if the file can't be loaded.
+     * Needs to be called before the logic threads start, after the groups are added and SetMemoryBudget.
+     */
+    bool LoadQueueProfile(const char* fileName);
+
+    /*!
+     * Adds a pass over the commands queued directly to each group. Passes run in the order they are added.
+     *
+     * Every frame, once the queues are swapped, the passes run over the render set on worker threads, one job per
+     * group, and Render waits for them before rendering the set. Each group's commands are given to the passes as a list
+     * of RenderPassCmd, in the order they were queued.
+     * If a pass that drops runs for a group, only the commands left in that list are rendered, still with the group's
+     * RenderSortMode. If a pass that reorders runs, the group is rendered in the order of the list instead, and its
+     * RenderSortMode isn't applied, since sorting is then up to the passes. Either way, Render still applies the time
+     * budget, and each view's culling.
+     *
+     * Returns the pass' index, for GetPassStats.
+     * Needs to be called before the logic threads start, like AddFont.
+     */
+    size_t AddPass(std::unique_ptr<RenderPass> pass);
+
+    static size_t GetNumPasses()
+    {
+        return Get().Passes.size();
+    }
+
+    static const RenderPass& GetPass(size_t index)
+    {
+        return *Get().Passes[index];
+    }
+
+    /*!
+     * Stats of a pass, for the last rendered frame.
+     * Safe to call from the logic threads.
+     */
+    static const RenderPassStats& GetPassStats(size_t index)
+    {
+        return Get().PublishedPassStats[index];
+    }
+
+    /*!
+     * Memory stats for the last rendered frame.
+     * Safe to call from the logic threads.
+     */
+    static const RenderMemoryStats& GetMemoryStats()
+    {
+        return Get().PublishedMemoryStats;
+    }
+
+    /*!
+     * Sets how long Render can take, in milliseconds. 0 disables the budget.
+     *
+     * The time is checked before each group, and every few commands. When over budget, the least important commands
+     * and groups (see RenderImportance) are dropped, escalating to more important ones the more it goes over. The next
+     * frame starts dropping at one level less than where the previous frame ended, so it doesn't keep missing the budget
+     * while recovering.
+     */
+    void SetRenderBudget(float ms)
+    {
+        RenderBudgetMs = ms;
+    }
+
+    /*!
+     * How many importance levels were being dropped at the end of the last rendered frame (0 if none).
+     * Safe to call from the logic threads.
+     */
+    static int GetDropLevel()
+    {
+        return Get().PublishedDropLevel;
+    }
+
+    /*!
+     * While in scope, commands with bounds and executions of blocks queued by the calling thread have the specified
+     * importance, which only has an effect if it's less important than their group's.
+     * Other commands (e.g text) can only be dropped along with their group.
+     */
+    class ImportanceScope
+    {
+      public:
+        explicit ImportanceScope(RenderImportance importance)
+            : Previous(CmdImportance)
+        {
+            CmdImportance = importance;
+        }
+
+        ~ImportanceScope()
+        {
+            CmdImportance = Previous;
+        }
+
+        ImportanceScope(const ImportanceScope&) = delete;
+        ImportanceScope& operator=(const ImportanceScope&) = delete;
+
+      private:
+        RenderImportance Previous;
+    };
+
+    /*!
+     * Sets the camera a group renders with, from this frame onwards.
+     * The group needs to have been created with the matching RenderCameraMode.
+     * For 3D groups, this is the same as setting a single view that covers the whole target, without culling.
+     */
+    static void SetCamera(RenderGroup group, const Camera3D& camera)
+    {
+        RenderView view;
+        view.Camera = camera;
+        view.Cull = false;
+        SetViews(group, std::span<const RenderView>(&view, 1));
+    }
+
+    static void SetCamera(RenderGroup group, const Camera2D& camera)
+    {
+        assert(GetGroupDesc(group).CameraMode == RenderCameraMode::Mode2D);
+        Get().LogicSet->Groups[group.Index]->Cam2D = camera;
+    }
+
+    /*!
+     * Sets the views a 3D group renders with, from this frame onwards.
+     * A CameraSnapshot is built for each view, which the logic side can then get with GetCamera.
+     * A 3D group doesn't render anything until it has at least one view.
+     *
+     * Needs to be called from the thread that owns the camera, before anything uses GetCamera for the frame.
+     */
+    static void SetViews(RenderGroup group, std::span<const RenderView> views);
+
+    static size_t GetNumViews(RenderGroup group)
+    {
+        return Get().LogicSet->Groups[group.Index]->Views.size();
+    }
+
+    /*!
+     * Camera snapshot a view of a 3D group will be rendered with, for the frame being recorded.
+     * Can be called from any thread, as long as the views are not being set at the same time.
+     */
+    static const CameraSnapshot& GetCamera(RenderGroup group, size_t viewIndex = 0)
+    {
+        return Get().LogicSet->Groups[group.Index]->Views[viewIndex].Camera;
+    }
+
+    /*!
+     * Arena for OOB data that needs to persist across frames. Render commands capture the PersistentArena::Ref
+     * instead of copying the data into the queue every frame.
+     */
+    static PersistentArena& GetArena()
+    {
+        return Get().Arena;
+    }
+
+    /*!
+     * Interns a string, so it can be drawn with the StringId overloads.
+     * Only the first time a string is interned does it get copied to the queues. Can be called from any thread.
+     */
+    static StringId Intern(std::string_view str);
+
+    /*!
+     * Registers a font for the text layout cache. Once a font is registered, the DrawText(StringId, ...) overload queues
+     * laid out glyphs instead of the text, using the font id passed to it (the first font by default).
+     * Needs to be called from the render thread (after the font is loaded), before the logic threads start.
+     */
+    uint32_t AddFont(const Font& font)
+    {
+        return TextLayouts.AddFont(font);
+    }
+
+    static const Font& GetFont(uint32_t fontId)
+    {
+        return Get().TextLayouts.GetFont(fontId);
+    }
+
+    /*!
+     * Gets the cached layout of an interned string, with the specified font.
+     * `func(const GlyphQuad* quads, size_t count)` is called while holding the cache's lock.
+     */
+    template<typename F>
+    static void GetTextLayout(StringId text, uint32_t fontId, int fontSize, F&& func)
+    {
+        RenderQueue& rq = Get();
+        rq.TextLayouts.Get(text, [&rq, text]() { return rq.Strings.Find(text); }, fontId, fontSize, std::forward<F>(func));
+    }
+
+    /*!
+     * Records a block of commands.
+     * Any command queued by `recordFunc` from the calling thread (no matter what RenderGroup they are meant for) goes
+     * into the block instead of the logic set.
+     */
+    template<typename F>
+    static std::shared_ptr<RenderCmdBlock> RecordBlock(F&& recordFunc)
+    {
+        std::shared_ptr<RenderCmdBlock> block = std::make_shared<RenderCmdBlock>();
+        Record(*block, std::forward<F>(recordFunc));
+        return block;
+    }
+
+    /*!
+     * Records commands into an existing block, such as a secondary returned by ExecuteSecondary.
+     * Any command queued by `recordFunc` from the calling thread goes into `target`.
+     */
+    template<typename F>
+    static void Record(RenderCmdBlock& target, F&& recordFunc)
+    {
+        RenderCmdBlock* previous = Recording;
+        Recording = &target;
+        recordFunc();
+        Recording = previous;
     }
 
+    /*!
+     * Queues the execution of a previously recorded block.
+     * The block's commands are not copied. The queue set keeps a reference to the block until it's rendered.
+     */
+    static void ExecuteBlock(RenderGroup group, std::shared_ptr<RenderCmdBlock> block);
+
+    /*!
+     * Gets a secondary command buffer from the logic set's pool, and queues its execution at this point of `group`'s
+     * queue.
+     * This allows the draw order to be decided when recording the primary queue, while the secondary itself is
+     * recorded later (with `Record`), possibly from another thread.
+     *
+     * Must be called from the thread recording the primary queue, and the secondary must be fully recorded before the
+     * frame ends. Secondaries are only valid for the current frame, and are recycled once the set is rendered.
+     */
+    static RenderCmdBlock& ExecuteSecondary(RenderGroup group);
+
     /*!
      * Process all render commands in the rendering set.
      */
@@ -67,27 +757,448 @@ class RenderQueue
     // The example commands match the Raylib's API, but that's not a requirement. Commands can be as simple or complex as you need.
     //
     static void DrawText(std::string_view text, int posX, int posY, int fontSize, Color color);
+    // Draws a null terminated string from the persistent arena (e.g created with GetArena().PushString), without copying it
+    static void DrawText(PersistentArena::Ref text, int posX, int posY, int fontSize, Color color);
+    // Draws an interned string. Only the id is queued, or the cached glyph quads if a font was registered with AddFont.
+    // `fontId` is the id AddFont returned, and is ignored if no font was registered (raylib's default font is used).
+    static void DrawText(StringId text, int posX, int posY, int fontSize, Color color, uint32_t fontId = 0);
+    // Formats the text with std::format directly into the queue's memory. Unlike raylib's TextFormat, this is thread safe.
+    template<typename... Args>
+    static void DrawTextF(int posX, int posY, int fontSize, Color color, std::format_string<Args...> fmt, Args&&... args)
+    {
+        RenderCmdQueue& q = GetQ(RenderGroup::UI);
+        PushDrawText(q, FormatString(q, fmt, std::forward<Args>(args)...), posX, posY, fontSize, color);
+    }
     static void DrawRectangle(int posX, int posY, int width, int height, Color color);
+    // Queues everything added to the batcher into the UI group, and resets the batcher
+    static void DrawBatch(UIBatcher& batcher);
     static void DrawCube(Vector3 position, float width, float height, float length, Color color);
     static void DrawCubeWires(Vector3 position, float width, float height, float length, Color color);
     // Renders a cube + wireframe, with a rotation
     static void DrawCubeEx(Vector3 position, float degrees, Vector3 rotationAxis, float width, float height, float length, Color color, Color wcolor);
 
+    /*!
+     * Same as calling DrawCubeEx for the cubes [begin, end) of a published snapshot, but only a small command is queued,
+     * which references the snapshot. The cubes are culled individually, but can only be dropped all at once.
+     * Only the frame's queues and secondaries can reference a snapshot. Blocks recorded with RecordBlock can be executed
+     * in later frames, after the snapshot is reused, so it's an error to call this while recording one (it asserts, and
+     * queues nothing).
+     */
+    static void DrawCubeRange(const CubeSnapshot& snapshot, uint32_t begin, uint32_t end);
+
+    /*!
+     * Gets an empty snapshot from the pool (see CubeSnapshot). Can be called from any logic thread.
+     */
+    static CubeSnapshot& AcquireCubeSnapshot();
+
+    /*!
+     * Gives a snapshot back to the pool. Ranges already queued stay valid, since the snapshot is only reused once the
+     * render thread is done with them. Can be called from any logic thread.
+     */
+    static void ReleaseCubeSnapshot(CubeSnapshot& snapshot);
+
+    /*!
+     * Render thread only, for commands that draw many cubes at once (see CubeColumns::DrawRows).
+     * Drops (if over the render budget) and culls (against the view being rendered) rows of cubes, and returns the
+     * indices of the rows left to draw, which are valid until the next call.
+     * \param importances Can be nullptr if the rows can't be dropped individually.
+     */
+    std::span<const uint32_t> GetVisibleCubeRows(const Vector3* positions, const Vector3* sizes, const RenderImportance* importances, uint32_t count);
+
+    /*!
+     * Same as calling DrawCubeEx `count` times, with `getCube(index)` returning the CubeDesc for each cube, but the
+     * vertices are generated by the calling thread, directly into the queue.
+     * The render thread then only needs to feed the vertices to rlgl, with a couple of draw calls.
+     * This is meant to be used from workers recording secondaries, so the generation is spread across threads.
+     */
+    template<typename F>
+    static void DrawCubesEx(uint32_t count, F&& getCube)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        RenderCmdQueue& q = GetQ(RenderGroup::World);
+        const uint32_t numTriangleVertices = count * WorldGeometry::CubeTriangleVertices;
+        const uint32_t numLineVertices = count * WorldGeometry::CubeLineVertices;
+        RenderCmdQueue::Ref ref = q.OobPushEmpty<ColorVertex>(numTriangleVertices + numLineVertices);
+        if (!ref.IsSet())
+        {
+            return;
+        }
+
+        // Nothing else is pushed to `q` until we are done, so the pointer stays valid
+        ColorVertex* triangles = &q.OobAtAs<ColorVertex>(ref);
+        ColorVertex* lines = triangles + numTriangleVertices;
+        Vector3 boundsMin = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        Vector3 boundsMax = {-boundsMin.x, -boundsMin.y, -boundsMin.z};
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const CubeDesc cube = getCube(i);
+            WorldGeometry::GenerateCube(cube, triangles, lines);
+            triangles += WorldGeometry::CubeTriangleVertices;
+            lines += WorldGeometry::CubeLineVertices;
+            AddBounds(boundsMin, boundsMax, cube.Position, GetCubeRadius(cube.Width, cube.Height, cube.Length));
+        }
+
+        const Vector3 center = {(boundsMin.x + boundsMax.x) / 2, (boundsMin.y + boundsMax.y) / 2, (boundsMin.z + boundsMax.z) / 2};
+        const float radius = GetCubeRadius(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z);
+        PushBounded(RenderGroup::World, center, radius, MakeStateKey(rlGetTextureIdDefault(), RL_TRIANGLES),
+            [ref, numTriangleVertices, numLineVertices](RenderCmdQueue& q)
+        {
+            const ColorVertex* vertices = &q.OobAtAs<ColorVertex>(ref);
+            WorldGeometry::Draw(RL_TRIANGLES, vertices, numTriangleVertices);
+            WorldGeometry::Draw(RL_LINES, vertices + numTriangleVertices, numLineVertices);
+        });
+    }
+
   private:
     inline static RenderQueue* Instance = nullptr;
 
+    // A view as set by the logic side, with the viewport already resolved
+    struct GroupView
+    {
+        RenderView View;
+        CameraSnapshot Camera;
+    };
+
+    // Sort info for a command queued directly to a group
+    struct CmdInfo
+    {
+        RenderCmdQueue::Ref Cmd;
+        // Bounding sphere
+        Vector3 Position;
+        float Radius;
+        uint32_t StateKey;
+        RenderImportance Importance;
+    };
+
+    // Per set data of a group
+    struct GroupQueue
+    {
+        RenderCmdQueue Q;
+
+        // Sort info, in the same order as the commands. Not all commands have it.
+        std::vector<CmdInfo> Infos;
+
+        // Rows pushed by DrawCubeEx, if the group doesn't sort
+        CubeColumns Cubes;
+        CompactCubeColumns CompactCubes;
+
+        // Camera for 2D groups
+        Camera2D Cam2D = {};
+        // Views for 3D groups
+        std::vector<GroupView> Views;
+
+        // Executions of blocks, in the same order as the commands, so the passes can see the blocks' bounds
+        struct BlockCmd
+        {
+            RenderCmdQueue::Ref Cmd;
+            const RenderCmdBlock* Block;
+        };
+        std::vector<BlockCmd> BlockCmds;
+
+        // Commands as left by the render passes. Only used for rendering if UsePassCmds is set (a pass dropped some), in
+        // which case PassesReorder tells if a pass also changed their order.
+        std::vector<RenderPassCmd> PassCmds;
+        bool UsePassCmds = false;
+        bool PassesReorder = false;
+        // Scratch space for RenderSortMode::Type, with PassCmds sorted by position in the queue
+        std::vector<const RenderPassCmd*> PassCmdsByPos;
+        // Stats of each pass, for this group
+        std::vector<RenderPassStats> PassStats;
+        // Scratch space for the passes' context
+        std::vector<RenderView> PassViews;
+        std::vector<CameraSnapshot> PassCameras;
+    };
+
+    // Data of a group that is shared by both sets
+    struct GroupData
+    {
+        RenderGroupDesc Desc;
+
+        // Render thread only. Each group has its own rlgl batch, sized for that group.
+        RenderBatch Batch;
+        RenderGroupStats Stats;
+
+        // Copy of the stats, updated when swapping the queues
+        RenderGroupStats PublishedStats;
+    };
+
     struct QueueSet
     {
-        RenderCmdQueue Q[static_cast<int>(RenderGroup::MAX)];
+        // Shared by all the group queues and secondaries. Declared first, so it outlives them.
+        RenderCmdQueueBudget Budget;
+
+        // Executed before any of the groups. Used for things like registering interned strings.
+        RenderCmdQueue Setup;
+
+        std::vector<std::unique_ptr<GroupQueue>> Groups;
+
+        // Keeps alive any blocks executed by this set, until it is rendered
+        std::vector<std::shared_ptr<RenderCmdBlock>> Blocks;
+
+        // Pool of secondary command buffers. Only the first `NumSecondaries` are in use.
+        std::vector<std::unique_ptr<RenderCmdBlock>> Secondaries;
+        size_t NumSecondaries = 0;
     } QSet[2];
 
     QueueSet* LogicSet;   // Queue that is being used by the game logic thread
     QueueSet* RenderSet;  // Queue that is being used by the raylib thread
 
+    PersistentArena Arena;
+
+    // Epoch of the frame the logic side is recording. Only changes when swapping the queues.
+    uint64_t Epoch = 1;
+    // Last epoch the render thread is done with. Anything only referenced by that epoch or older can be reused.
+    std::atomic<uint64_t> CompletedEpoch = 0;
+
+    // Pool of snapshots (see CubeSnapshot)
+    std::mutex SnapshotsMtx;
+    std::vector<std::unique_ptr<CubeSnapshot>> Snapshots;
+
+    // Memory limit for each of the queues of a set
+    uint32_t QueueMaxCapacity = 0;
+    RenderCmdQueue::SizingPolicy QueueSizing;
+    QueueAllocator* QueueAlloc = nullptr;
+    // Render thread only. Most secondaries a set used in a frame, for the profile.
+    size_t PeakSecondaries = 0;
+    RenderMemoryStats MemoryStats;
+    RenderMemoryStats PublishedMemoryStats;
+
+    std::vector<std::unique_ptr<GroupData>> Groups;
+    // Group indices, sorted by priority
+    std::vector<uint32_t> GroupOrder;
+
+    // Render thread only. Scratch space to sort the commands of a group.
+    struct SortEntry
+    {
+        RenderCmdQueue::Ref Cmd;
+        // State keys are used as is, and distances are converted with DistanceSortKey, so all modes sort on integers
+        uint32_t Key;
+    };
+    std::vector<SortEntry> SortEntries;
+
+    // Render thread only. Scratch space for the cube columns.
+    std::vector<uint32_t> VisibleRows;
+
+    bool CompactCommands = false;
+
+    // Render thread only. Frustum of the view being rendered, if it culls.
+    const Frustum* CullFrustum = nullptr;
+    uint32_t NumCulled = 0;
+
+    // Render thread only. Time budget state.
+    // Number of commands between time checks
+    inline static constexpr uint32_t BudgetCheckInterval = 32;
+    float RenderBudgetMs = 0;
+    std::chrono::high_resolution_clock::time_point RenderStart;
+    // Number of importance levels being dropped. 0 means nothing is dropped.
+    int DropLevel = 0;
+    int PublishedDropLevel = 0;
+    // Importance of the group being rendered
+    RenderImportance GroupImportance = RenderImportance::Required;
+    uint32_t NumDropped = 0;
+
+    // Importance for commands queued by the calling thread (see ImportanceScope)
+    inline static thread_local RenderImportance CmdImportance = RenderImportance::Required;
+
+    StringInterner Strings;
+    TextLayoutCache TextLayouts;
+
+    // Render passes (see AddPass)
+    std::vector<std::unique_ptr<RenderPass>> Passes;
+    // Render thread only, until published
+    std::vector<RenderPassStats> PassStats;
+    std::vector<RenderPassStats> PublishedPassStats;
+
+    // What the pass workers run for each group
+    struct RunPassesJob
+    {
+        RenderQueue* Rq;
+        void operator()(int groupIndex) const
+        {
+            Rq->RunPasses(*Rq->RenderSet->Groups[groupIndex], groupIndex);
+        }
+    } PassJob{this};
+
+    inline static constexpr int NumPassWorkers = 2;
+    // Declared last, so the workers are stopped before anything they use is destroyed
+    std::unique_ptr<WorkerPool> PassWorkers;
+
+    /*!
+     * Applies the allocator, limits and sizing policy to a queue of the specified set
+     */
+    void ConfigureQueue(QueueSet& set, RenderCmdQueue& q, QueueAllocator* allocator) const
+    {
+        q.SetAllocator(allocator ? allocator : QueueAlloc);
+        q.SetMaxCapacity(QueueMaxCapacity);
+        q.SetBudget(&set.Budget);
+        q.SetSizingPolicy(QueueSizing);
+    }
+
+    // Applies ConfigureQueue to all the group queues and secondaries of a set
+    void ConfigureQueues(QueueSet& set);
+
+    RenderCmdBlock& AddSecondary(QueueSet& set);
+
+    /*!
+     * Formats a null terminated string into the queue's OOB data.
+     * The space is reserved with a guess, and trimmed afterwards, so that the common case formats in a single pass. Only
+     * if the guess is too small does it need to format again.
+     */
+    template<typename... Args>
+    static RenderCmdQueue::Ref FormatString(RenderCmdQueue& q, std::format_string<Args...> fmt, Args&&... args)
+    {
+        size_t reserved = fmt.get().size() + 32;
+        RenderCmdQueue::Ref ref = q.OobPushEmpty<char>(reserved + 1);
+        if (!ref.IsSet())
+        {
+            return ref;
+        }
+
+        char* ptr = reinterpret_cast<char*>(q.OobAt(ref));
+        auto res = std::format_to_n(ptr, static_cast<std::ptrdiff_t>(reserved), fmt, std::forward<Args>(args)...);
+
+        size_t size = static_cast<size_t>(res.size);
+        if (size > reserved)
+        {
+            // Didn't fit, so give back the space and try again with the exact size
+            q.OobTrim(ref, 0);
+            ref = q.OobPushEmpty<char>(size + 1);
+            if (!ref.IsSet())
+            {
+                return ref;
+            }
+
+            ptr = reinterpret_cast<char*>(q.OobAt(ref));
+            std::format_to_n(ptr, static_cast<std::ptrdiff_t>(size), fmt, std::forward<Args>(args)...);
+        }
+
+        ptr[size] = 0;
+        q.OobTrim(ref, size + 1);
+        return ref;
+    }
+
+    // Renders the commands queued directly to a group, reordering them according to `sortMode`, and culling them against
+    // CullFrustum, if set.
+    void RenderGroupCmds(GroupQueue& group, RenderSortMode sortMode, const Vector3& viewPos);
+
+    // Runs the render passes for one of the render set's groups. Called from the pass workers.
+    void RunPasses(GroupQueue& groupQ, int groupIndex);
+
+    // RenderGroupCmds for groups with UsePassCmds set, when the list's order is the one to render in
+    void RenderPassCmds(GroupQueue& group);
+
+    // RenderGroupCmds for RenderSortMode::Type
+    void RenderGroupCmdsByType(GroupQueue& group);
+
+    // RenderGroupCmdsByType for groups with UsePassCmds set, where the passes didn't reorder the commands
+    void RenderPassCmdsByType(GroupQueue& group);
+
+    static size_t GetUsedBytes(const GroupQueue& groupQ)
+    {
+        return groupQ.Q.GetUsedCapacity() + groupQ.Cubes.GetUsedBytes() + groupQ.CompactCubes.GetUsedBytes();
+    }
+
+    // Renders a 3D group with one of its views
+    void RenderGroupView(GroupQueue& group, RenderSortMode sortMode, const GroupView& view, int targetHeight);
+
+    // Called when replaying the execution of a block. Returns false if the block is culled.
+    bool IsBlockVisible(const RenderCmdBlock& block);
+
+    // Bounding sphere of a block. Returns false if not all of the block's commands have bounds.
+    static bool GetBlockSphere(const RenderCmdBlock& block, Vector3& center, float& radius);
+
+    // Drops, culls or runs an entry of the passes' commands
+    void RunPassCmd(GroupQueue& group, const RenderPassCmd& cmd);
+
+    // Checks the time, and raises the drop level if over budget
+    void UpdateDropLevel();
+
+    // Returns true if something with the specified importance should be dropped at the current drop level.
+    // The effective importance is the least important of `importance` and the group's.
+    bool ShouldDrop(RenderImportance importance) const
+    {
+        const int level = static_cast<int>(std::max(importance, GroupImportance));
+        return level != static_cast<int>(RenderImportance::Required) && level > static_cast<int>(RenderImportance::Low) - DropLevel;
+    }
+
+    // Called when replaying the execution of a block. Checks the time, and returns true (counting it) if the block
+    // should be dropped.
+    bool CheckDropBlock(RenderImportance importance)
+    {
+        UpdateDropLevel();
+        if (ShouldDrop(importance))
+        {
+            NumDropped++;
+            return true;
+        }
+        return false;
+    }
+
+    /*!
+     * Queues a command that carries a bounding sphere and sort info.
+     * Commands queued while recording a block only add to the block's bounds, since the block is executed as a single
+     * command.
+     */
+    template<typename F>
+    static void PushBounded(RenderGroup group, Vector3 position, float radius, uint32_t stateKey, F&& f)
+    {
+        RenderCmdQueue::Ref ref = GetQ(group).Push(std::forward<F>(f));
+        if (!ref.IsSet())
+        {
+            return;
+        }
+
+        if (Recording)
+        {
+            if (Recording->NumBounded++ == 0)
+            {
+                Recording->BoundsMin = Recording->BoundsMax = position;
+            }
+            AddBounds(Recording->BoundsMin, Recording->BoundsMax, position, radius);
+        }
+        else
+        {
+            Get().LogicSet->Groups[group.Index]->Infos.push_back({ref, position, radius, stateKey, CmdImportance});
+        }
+    }
+
+    static void AddBounds(Vector3& boundsMin, Vector3& boundsMax, const Vector3& position, float radius)
+    {
+        boundsMin = {std::min(boundsMin.x, position.x - radius), std::min(boundsMin.y, position.y - radius), std::min(boundsMin.z, position.z - radius)};
+        boundsMax = {std::max(boundsMax.x, position.x + radius), std::max(boundsMax.y, position.y + radius), std::max(boundsMax.z, position.z + radius)};
+    }
+
+    // Radius of the bounding sphere of a box, no matter its rotation
+    static float GetCubeRadius(float width, float height, float length)
+    {
+        return std::sqrt(width * width + height * height + length * length) / 2;
+    }
+
+    // State key for sorting, from the texture and primitive a command draws with
+    static uint32_t MakeStateKey(unsigned int textureId, int mode)
+    {
+        return (textureId << 4) | static_cast<uint32_t>(mode & 0xF);
+    }
+
+    // Queues the command to draw a string previously pushed as OOB data
+    static void PushDrawText(RenderCmdQueue& q, RenderCmdQueue::Ref textRef, int posX, int posY, int fontSize, Color color);
+
+    // Block being recorded by the calling thread, if any
+    inline static thread_local RenderCmdBlock* Recording = nullptr;
+
     // Shortcut to get the queue to insert new render commands
     static RenderCmdQueue& GetQ(RenderGroup group)
     {
-        return RenderQueue::Get().LogicSet->Q[static_cast<int>(group)];
+        if (Recording)
+        {
+            return Recording->Q;
+        }
+
+        return RenderQueue::Get().LogicSet->Groups[group.Index]->Q;
     }
 
 };
@@ -0,0 +1,130 @@
+/*******************************************************************************************
+*
+*   Frame-stable string interner.
+*
+*   Strings that are drawn every frame (labels, help text, etc) can be interned once, and from
+*   then on render commands only need to carry a 32 bits id.
+*
+*   It has two sides:
+*   - The logic side (Intern), which maps strings to ids. Any thread can intern strings.
+*   - The render side (Register/Resolve), which maps ids back to strings. Only the render
+*     thread touches it.
+*   Whenever the logic side creates a new id, the user code (RenderQueue) is responsible for
+*   sending the string over to the render side, so only new strings cost bytes in the queues.
+*
+*   Ids are never recycled, so this is meant for strings that are reused, not for text that
+*   changes every frame.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <assert.h>
+
+struct StringId
+{
+    inline static constexpr uint32_t InvalidValue = std::numeric_limits<uint32_t>::max();
+
+    bool IsSet() const noexcept
+    {
+        return Value != InvalidValue;
+    }
+
+    bool operator==(const StringId&) const = default;
+
+    uint32_t Value = InvalidValue;
+};
+
+class StringInterner
+{
+  public:
+
+    /*!
+     * Logic side. Returns the id for the specified string.
+     *
+     * \param onNew
+     *      Called (while still holding the interner's lock) if the string didn't have an id yet, with the new id and
+     *      the string. This is where the caller sends the string over to the render side, and holding the lock
+     *      guarantees the registration is queued before anyone else can use the id.
+     */
+    template<typename F>
+    StringId Intern(std::string_view str, F&& onNew)
+    {
+        std::unique_lock lock(Mtx);
+        auto it = Ids.find(str);
+        if (it != Ids.end())
+        {
+            return it->second;
+        }
+
+        StringId id{static_cast<uint32_t>(Ids.size())};
+        it = Ids.emplace(std::string(str), id).first;
+        ById.push_back(&it->first);
+        onNew(id, str);
+        return id;
+    }
+
+    /*!
+     * Logic side. Returns the string for an id. The string is null terminated.
+     */
+    std::string_view Find(StringId id)
+    {
+        std::unique_lock lock(Mtx);
+        assert(id.Value < ById.size());
+        return *ById[id.Value];
+    }
+
+    /*!
+     * Render side. Registers the string for an id created by Intern.
+     */
+    void Register(StringId id, std::string_view str)
+    {
+        if (id.Value >= Strings.size())
+        {
+            Strings.resize(id.Value + 1);
+        }
+        Strings[id.Value] = str;
+    }
+
+    /*!
+     * Render side. Returns the null terminated string for the specified id.
+     */
+    const char* Resolve(StringId id) const
+    {
+        assert(id.Value < Strings.size());
+        return Strings[id.Value].c_str();
+    }
+
+  private:
+
+    // Allows looking up with a std::string_view without creating a temporary std::string
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view str) const
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    // Logic side
+    std::mutex Mtx;
+    std::unordered_map<std::string, StringId, Hash, std::equal_to<>> Ids;
+    // The map's nodes don't move, so we can point to the keys
+    std::vector<const std::string*> ById;
+
+    // Render side
+    std::vector<std::string> Strings;
+};
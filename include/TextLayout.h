@@ -0,0 +1,158 @@
+/*******************************************************************************************
+*
+*   Text layout, done outside of the render thread.
+*
+*   raylib's DrawText walks the string, decodes the codepoints and looks up the glyphs every
+*   time it's called. Instead, the logic side can lay out the text into glyph quads (screen
+*   rectangle + texture coordinates), cache them, and queue those, so the render thread only
+*   has to emit the vertices.
+*
+*   - Fonts are registered once (after being loaded by the render thread), and from then on
+*     only read, so they can be shared by any thread.
+*   - Layout doesn't touch the GPU, so it can run (and be benchmarked) headless, as long as the
+*     Font's glyph data is available.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "StringInterner.h"
+
+#include "raylib.h"
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * A laid out glyph, relative to the text's origin.
+ */
+struct GlyphQuad
+{
+    // Screen rectangle
+    float X0, Y0, X1, Y1;
+    // Normalized texture coordinates
+    float U0, V0, U1, V1;
+};
+
+class TextLayoutCache
+{
+  public:
+
+    // raylib's default line spacing (see SetTextLineSpacing)
+    inline static constexpr int DefaultLineSpacing = 2;
+
+    /*!
+     * Registers a font, and returns its id.
+     * Fonts need to be registered before any other thread uses the cache, since after that they are only read.
+     */
+    uint32_t AddFont(const Font& font)
+    {
+        Fonts.push_back(font);
+        return static_cast<uint32_t>(Fonts.size() - 1);
+    }
+
+    uint32_t GetNumFonts() const
+    {
+        return static_cast<uint32_t>(Fonts.size());
+    }
+
+    const Font& GetFont(uint32_t fontId) const
+    {
+        return Fonts[fontId];
+    }
+
+    /*!
+     * Lays out the text the same way raylib's DrawText does, appending the quads to `out`.
+     * It's stateless, and doesn't touch the GPU.
+     */
+    static void Layout(const Font& font, std::string_view text, int fontSize, std::vector<GlyphQuad>& out, int lineSpacing = DefaultLineSpacing);
+
+    /*!
+     * Gets the cached layout for an interned string, laying it out if necessary.
+     * Can be called from any thread. `func(const GlyphQuad* quads, size_t count)` is called while holding the cache's
+     * lock, since the quads can move if another thread adds to the cache.
+     * Hits only take a shared lock, so threads drawing cached text don't serialize on each other.
+     *
+     * \param getText
+     *      Returns the string `id` refers to. Only called if the layout is not cached yet, so hits don't need to touch
+     *      the interner.
+     */
+    template<typename TextF, typename F>
+    void Get(StringId id, TextF&& getText, uint32_t fontId, int fontSize, F&& func)
+    {
+        Key key{id.Value, fontId, fontSize};
+
+        {
+            std::shared_lock lock(Mtx);
+            auto it = Entries.find(key);
+            if (it != Entries.end())
+            {
+                func(Quads.data() + it->second.Offset, static_cast<size_t>(it->second.Count));
+                return;
+            }
+        }
+
+        // Slow path. Get the text before locking, so we don't hold both our lock and the interner's
+        std::string_view text = getText();
+
+        std::unique_lock lock(Mtx);
+        // Another thread might have laid it out in the meantime
+        auto it = Entries.find(key);
+        if (it == Entries.end())
+        {
+            Entry entry;
+            entry.Offset = static_cast<uint32_t>(Quads.size());
+            Layout(Fonts[fontId], text, fontSize, Quads);
+            entry.Count = static_cast<uint32_t>(Quads.size()) - entry.Offset;
+            it = Entries.emplace(key, entry).first;
+        }
+
+        func(Quads.data() + it->second.Offset, static_cast<size_t>(it->second.Count));
+    }
+
+    /*!
+     * Render side. Emits the vertices for the quads, translated by (x,y).
+     */
+    static void Draw(const Font& font, const GlyphQuad* quads, size_t count, float x, float y, Color tint);
+
+  private:
+
+    struct Key
+    {
+        uint32_t Text;
+        uint32_t FontId;
+        int FontSize;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<uint64_t>{}((static_cast<uint64_t>(key.Text) << 32) ^ (static_cast<uint64_t>(key.FontId) << 16) ^ static_cast<uint64_t>(key.FontSize));
+        }
+    };
+
+    struct Entry
+    {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+    // Read only once other threads are using the cache
+    std::vector<Font> Fonts;
+
+    std::shared_mutex Mtx;
+    std::unordered_map<Key, Entry, KeyHash> Entries;
+    std::vector<GlyphQuad> Quads;
+};
@@ -0,0 +1,132 @@
+/*******************************************************************************************
+*
+*   Batches UI rectangles, text and sprites into one vertex buffer per texture.
+*
+*   All the work of generating the vertices is done on the logic side. The vertices are then
+*   pushed as OOB data, and the render thread only needs to feed each batch to rlgl, which ends
+*   up as one draw call per batch, instead of one immediate mode raylib call per element.
+*
+*   Batches are drawn in the order their textures were first used (e.g rectangles first, then
+*   text, if the first thing added is a rectangle). If elements with different textures need to
+*   be interleaved, call Submit in between.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "RenderCmdQueue.h"
+#include "TextLayout.h"
+
+#include "raylib.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if __has_include(<format>)
+    #include <format>
+#else
+    #error This sample requires support for std::format
+#endif
+
+class UIBatcher
+{
+  public:
+
+    struct Vertex
+    {
+        float X, Y;
+        float U, V;
+        Color Col;
+    };
+
+    struct Stats
+    {
+        uint32_t NumBatches = 0;
+        uint32_t NumVertices = 0;
+        uint32_t NumBytes = 0;
+    };
+
+    void AddRect(float x, float y, float width, float height, Color color);
+    void AddSprite(const Texture2D& texture, Rectangle source, Rectangle dest, Color tint);
+
+    // Adds already laid out glyphs (e.g from TextLayoutCache), translated by (x,y)
+    void AddGlyphs(const Font& font, const GlyphQuad* quads, size_t count, float x, float y, Color color);
+
+    // Lays out and adds the text
+    void AddText(const Font& font, std::string_view text, float x, float y, int fontSize, Color color);
+
+    // Formats, lays out and adds the text. Nothing is allocated, unless the text doesn't fit in a 256 bytes stack buffer.
+    template<typename... Args>
+    void AddTextF(const Font& font, float x, float y, int fontSize, Color color, std::format_string<Args...> fmt, Args&&... args)
+    {
+        char buf[256];
+        auto res = std::format_to_n(buf, sizeof(buf) - 1, fmt, std::forward<Args>(args)...);
+        if (static_cast<size_t>(res.size) < sizeof(buf))
+        {
+            *res.out = 0;
+            AddText(font, std::string_view(buf, res.out), x, y, fontSize, color);
+        }
+        else
+        {
+            AddText(font, std::format(fmt, std::forward<Args>(args)...), x, y, fontSize, color);
+        }
+    }
+
+    /*!
+     * Queues all the batches into `q` (as OOB data plus one command per batch), and resets the batcher.
+     */
+    void Submit(RenderCmdQueue& q);
+
+    /*!
+     * Stats for everything submitted since the last call to ResetStats
+     */
+    const Stats& GetStats() const
+    {
+        return CurrStats;
+    }
+
+    void ResetStats()
+    {
+        CurrStats = {};
+    }
+
+    /*!
+     * Render side. Draws a batch.
+     */
+    static void Draw(unsigned int textureId, const Vertex* vertices, uint32_t count);
+
+  private:
+
+    struct Batch
+    {
+        unsigned int TextureId = 0;
+        std::vector<Vertex> Vertices;
+    };
+
+    Batch& GetBatch(unsigned int textureId);
+
+    static void AddQuad(Batch& batch, float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, Color color)
+    {
+        // Same order as raylib uses for RL_QUADS
+        batch.Vertices.push_back({x0, y0, u0, v0, color});
+        batch.Vertices.push_back({x0, y1, u0, v1, color});
+        batch.Vertices.push_back({x1, y1, u1, v1, color});
+        batch.Vertices.push_back({x1, y0, u1, v0, color});
+    }
+
+    // Batches are kept around between frames, so their vectors keep their capacity. Only the first `NumBatches` are in
+    // use.
+    std::vector<Batch> Batches;
+    size_t NumBatches = 0;
+
+    // Scratch space for text layout
+    std::vector<GlyphQuad> Glyphs;
+
+    Stats CurrStats;
+};
@@ -0,0 +1,201 @@
+/*******************************************************************************************
+*
+*   Simple pool of worker threads, to split a thread's frame work into parallel jobs.
+*
+*   Unlike FrameThread, the workers are not part of the frame synchronization. They are owned
+*   by another thread, which hands them work with ParallelFor and waits for it to complete.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class WorkerPool
+{
+  public:
+
+    /*!
+     * \param numThreads
+     *      Number of worker threads to create. The thread calling ParallelFor also does work, so a value of 0 is
+     *      allowed, and just runs everything in the calling thread.
+     */
+    explicit WorkerPool(int numThreads)
+    {
+        for (int i = 0; i < numThreads; i++)
+        {
+            Threads.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::unique_lock lock(Mtx);
+            Finish = true;
+        }
+        WakeCv.notify_all();
+
+        for (std::thread& th : Threads)
+        {
+            th.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int GetNumThreads() const
+    {
+        return static_cast<int>(Threads.size());
+    }
+
+    /*!
+     * Calls `func(index)` for every index in [0, count), spread across the workers and the calling thread.
+     * Returns once all calls are done.
+     * Only one thread at a time should call this.
+     *
+     * No memory is allocated, since `func` is only referenced for the duration of the call.
+     */
+    template<typename F>
+    void ParallelFor(int count, F&& func)
+    {
+        using FuncType = std::remove_reference_t<F>;
+
+        {
+            std::unique_lock lock(Mtx);
+            // Make sure no worker is still inside the previous job
+            DoneCv.wait(lock, [this]() { return Busy == 0; });
+
+            CurrentJob.Func = [](void* ctx, int index) { (*static_cast<FuncType*>(ctx))(index); };
+            CurrentJob.Ctx = const_cast<void*>(static_cast<const void*>(std::addressof(func)));
+            CurrentJob.Count = count;
+            NextIndex = 0;
+            Pending = count;
+            ++Generation;
+        }
+        WakeCv.notify_all();
+
+        Run(CurrentJob);
+
+        std::unique_lock lock(Mtx);
+        DoneCv.wait(lock, [this]() { return Pending == 0 && Busy == 0; });
+    }
+
+    /*!
+     * Same as ParallelFor, but returns straight away, and the calling thread doesn't do any of the work (unless there
+     * are no workers, in which case it does all of it before returning).
+     * Wait needs to be called before `func` goes out of scope, and before the next ParallelFor/ParallelForAsync.
+     */
+    template<typename F>
+    void ParallelForAsync(int count, F& func)
+    {
+        if (Threads.empty())
+        {
+            for (int i = 0; i < count; i++)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        {
+            std::unique_lock lock(Mtx);
+            DoneCv.wait(lock, [this]() { return Busy == 0; });
+
+            CurrentJob.Func = [](void* ctx, int index) { (*static_cast<F*>(ctx))(index); };
+            CurrentJob.Ctx = static_cast<void*>(std::addressof(func));
+            CurrentJob.Count = count;
+            NextIndex = 0;
+            Pending = count;
+            ++Generation;
+        }
+        WakeCv.notify_all();
+    }
+
+    /*!
+     * Waits for the work started with ParallelForAsync to complete.
+     */
+    void Wait()
+    {
+        std::unique_lock lock(Mtx);
+        DoneCv.wait(lock, [this]() { return Pending == 0 && Busy == 0; });
+    }
+
+  private:
+
+    struct Job
+    {
+        void (*Func)(void*, int) = nullptr;
+        void* Ctx = nullptr;
+        int Count = 0;
+    };
+
+    void Run(const Job& job)
+    {
+        int index;
+        while ((index = NextIndex.fetch_add(1)) < job.Count)
+        {
+            job.Func(job.Ctx, index);
+            if (Pending.fetch_sub(1) == 1)
+            {
+                std::unique_lock lock(Mtx);
+                DoneCv.notify_all();
+            }
+        }
+    }
+
+    void WorkerLoop()
+    {
+        uint64_t seenGeneration = 0;
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock lock(Mtx);
+                WakeCv.wait(lock, [&]() { return Finish || Generation != seenGeneration; });
+                if (Finish)
+                {
+                    return;
+                }
+
+                seenGeneration = Generation;
+                job = CurrentJob;
+                ++Busy;
+            }
+
+            Run(job);
+
+            {
+                std::unique_lock lock(Mtx);
+                --Busy;
+            }
+            DoneCv.notify_all();
+        }
+    }
+
+    std::mutex Mtx;
+    std::condition_variable WakeCv;
+    std::condition_variable DoneCv;
+
+    Job CurrentJob;
+    uint64_t Generation = 0;
+    int Busy = 0;
+    bool Finish = false;
+
+    std::atomic<int> NextIndex = 0;
+    std::atomic<int> Pending = 0;
+
+    std::vector<std::thread> Threads;
+};
@@ -0,0 +1,64 @@
+/*******************************************************************************************
+*
+*   CPU side generation of world geometry.
+*
+*   raylib's DrawCube/DrawCubeWires make the render thread generate and transform every vertex.
+*   Instead, the logic side (e.g worker threads recording secondaries) can generate the final,
+*   already transformed vertices straight into the queue's OOB data, and the render thread only
+*   needs to feed them to rlgl, with a couple of draw calls per batch of cubes.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#pragma once
+
+#include "raylib.h"
+
+#include <cstdint>
+
+/*!
+ * Position + color, which is all that cubes need.
+ */
+struct ColorVertex
+{
+    float X, Y, Z;
+    Color Col;
+};
+
+/*!
+ * Parameters for a cube + wireframe, with a rotation (same as RenderQueue::DrawCubeEx)
+ */
+struct CubeDesc
+{
+    Vector3 Position;
+    float Degrees;
+    Vector3 RotationAxis;
+    float Width;
+    float Height;
+    float Length;
+    Color CubeColor;
+    Color WireColor;
+};
+
+namespace WorldGeometry
+{
+    inline constexpr uint32_t CubeTriangleVertices = 36;
+    inline constexpr uint32_t CubeLineVertices = 24;
+
+    /*!
+     * Generates the transformed vertices for a cube.
+     * \param triangles Where to write the `CubeTriangleVertices` vertices for the faces
+     * \param lines Where to write the `CubeLineVertices` vertices for the wireframe
+     */
+    void GenerateCube(const CubeDesc& cube, ColorVertex* triangles, ColorVertex* lines);
+
+    /*!
+     * Render side. Draws already transformed vertices.
+     * \param mode RL_TRIANGLES or RL_LINES
+     */
+    void Draw(int mode, const ColorVertex* vertices, uint32_t count);
+} // namespace WorldGeometry
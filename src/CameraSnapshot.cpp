@@ -0,0 +1,54 @@
+/*******************************************************************************************
+*
+*   Immutable snapshot of a 3D camera, for one frame.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "CameraSnapshot.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+CameraSnapshot CameraSnapshot::Make(const Camera3D& camera, float aspect)
+{
+    CameraSnapshot res;
+    res.Camera = camera;
+    res.Aspect = aspect;
+
+    if (camera.projection == CAMERA_PERSPECTIVE)
+    {
+        res.Projection = MatrixPerspective(camera.fovy * DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+    else
+    {
+        const double top = camera.fovy / 2.0;
+        const double right = top * aspect;
+        res.Projection = MatrixOrtho(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    }
+
+    res.View = MatrixLookAt(camera.position, camera.target, camera.up);
+    res.ViewProjection = MatrixMultiply(res.View, res.Projection);
+    res.ViewFrustum = Frustum::FromMatrix(res.ViewProjection);
+    return res;
+}
+
+void CameraSnapshot::Begin() const
+{
+    // Anything drawn so far uses the previous matrices
+    rlDrawRenderBatchActive();
+
+    rlMatrixMode(RL_PROJECTION);
+    rlPushMatrix();
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(Projection));
+
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(View));
+
+    rlEnableDepthTest();
+}
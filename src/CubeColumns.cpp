@@ -0,0 +1,162 @@
+/*******************************************************************************************
+*
+*   Column storage for DrawCubeEx.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "CubeColumns.h"
+#include "RenderQueue.h"
+#include "RenderBatch.h"
+#include "Quantize.h"
+#include "rlgl.h"
+#include "raymath.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <vector>
+
+namespace
+{
+    // Render thread only. Transforms of the visible rows, built once for both the cubes and the wireframes.
+    std::vector<Matrix> RowMatrices;
+
+    // Render thread only. Rows of the compact columns, decoded back to full precision.
+    std::vector<Vector3> DecodedPositions;
+    std::vector<Vector3> DecodedAxes;
+    std::vector<float> DecodedDegrees;
+    std::vector<Vector3> DecodedSizes;
+}
+
+bool CubeColumns::Push(RenderCmdQueue& q, CubeColumns& columns, Vector3 position, float degrees, Vector3 rotationAxis, float width, float height,
+    float length, Color color, Color wcolor, RenderImportance importance)
+{
+    return q.PushRow(columns, position, rotationAxis, degrees, Vector3{width, height, length}, color, wcolor, importance);
+}
+
+void CubeColumns::CallRange(RenderCmdQueue&, const CubeColumns& columns, uint32_t begin, uint32_t count)
+{
+    DrawRows(columns.Get<Position>() + begin, columns.Get<RotationAxis>() + begin, columns.Get<Degrees>() + begin, columns.Get<Size>() + begin,
+        columns.Get<CubeColor>() + begin, columns.Get<WiresColor>() + begin, columns.Get<Importance>() + begin, count);
+}
+
+void CubeColumns::DrawRows(const Vector3* positions, const Vector3* axes, const float* degrees, const Vector3* sizes, const Color* cubeColors,
+    const Color* wiresColors, const RenderImportance* importances, uint32_t count)
+{
+    // Drop and cull first, so the following passes only see the visible rows
+    const std::span<const uint32_t> visibleRows = RenderQueue::Get().GetVisibleCubeRows(positions, sizes, importances, count);
+
+    RowMatrices.clear();
+    for (uint32_t i : visibleRows)
+    {
+        RowMatrices.push_back(MatrixMultiply(MatrixRotate(axes[i], degrees[i] * DEG2RAD), MatrixTranslate(positions[i].x, positions[i].y, positions[i].z)));
+    }
+
+    // All the cubes, then all the wireframes, so rlgl doesn't need a new draw call for every cube
+    for (size_t j = 0; j < visibleRows.size(); j++)
+    {
+        const uint32_t i = visibleRows[j];
+        RenderBatch::Reserve(36);
+        ::rlPushMatrix();
+            ::rlMultMatrixf(MatrixToFloat(RowMatrices[j]));
+            ::DrawCube({}, sizes[i].x, sizes[i].y, sizes[i].z, cubeColors[i]);
+        ::rlPopMatrix();
+    }
+
+    for (size_t j = 0; j < visibleRows.size(); j++)
+    {
+        const uint32_t i = visibleRows[j];
+        RenderBatch::Reserve(24);
+        ::rlPushMatrix();
+            ::rlMultMatrixf(MatrixToFloat(RowMatrices[j]));
+            ::DrawCubeWires({}, sizes[i].x, sizes[i].y, sizes[i].z, wiresColors[i]);
+        ::rlPopMatrix();
+    }
+}
+
+bool CompactCubeColumns::Push(RenderCmdQueue& q, CompactCubeColumns& columns, Vector3 position, float degrees, Vector3 rotationAxis, float width,
+    float height, float length, Color color, Color wcolor, RenderImportance importance)
+{
+    if (width > Quantize::HalfMax || height > Quantize::HalfMax || length > Quantize::HalfMax)
+    {
+        return false;
+    }
+
+    // Rows are deltas from their run's base. If this one is too far from it, it starts a new run, with itself as the base.
+    bool newRun = !q.ContinuesRowRun(columns);
+    Vector3 delta = {};
+    if (!newRun)
+    {
+        delta = Vector3Subtract(position, columns.Bases.back().Position);
+        if (!Quantize::FitsFixed16(delta.x, PositionScale) || !Quantize::FitsFixed16(delta.y, PositionScale) ||
+            !Quantize::FitsFixed16(delta.z, PositionScale))
+        {
+            q.EndRowRun();
+            newRun = true;
+            delta = {};
+        }
+    }
+
+    const Vector3 axis = Vector3Normalize(rotationAxis);
+    if (q.PushRow(columns, Quantize::FloatToFixed16(delta.x, PositionScale), Quantize::FloatToFixed16(delta.y, PositionScale),
+        Quantize::FloatToFixed16(delta.z, PositionScale), Quantize::FloatToSnorm16(axis.x), Quantize::FloatToSnorm16(axis.y),
+        Quantize::FloatToSnorm16(axis.z), Quantize::DegreesToAngle16(degrees), Quantize::FloatToHalf(width), Quantize::FloatToHalf(height),
+        Quantize::FloatToHalf(length), color, wcolor, importance) && newRun)
+    {
+        columns.Bases.push_back({columns.GetSize() - 1, position});
+    }
+
+    // A failed push is counted by the queue, and there is no point in trying again at full precision
+    return true;
+}
+
+void CompactCubeColumns::CallRange(RenderCmdQueue&, const CompactCubeColumns& columns, uint32_t begin, uint32_t count)
+{
+    DecodedPositions.resize(count);
+    DecodedAxes.resize(count);
+    DecodedDegrees.resize(count);
+    DecodedSizes.resize(count);
+
+    // The queue calls this once per run, so `begin` is always the start of one
+    auto it = std::lower_bound(columns.Bases.begin(), columns.Bases.end(), begin, [](const RunBase& base, uint32_t row)
+    {
+        return base.Begin < row;
+    });
+    assert(it != columns.Bases.end() && it->Begin == begin);
+    const Vector3 base = it->Position;
+
+    // Each field is decoded in its own loop, so they can be vectorized
+    const int16_t* dx = columns.Get<DeltaX>() + begin;
+    const int16_t* dy = columns.Get<DeltaY>() + begin;
+    const int16_t* dz = columns.Get<DeltaZ>() + begin;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        DecodedPositions[i] = {base.x + Quantize::Fixed16ToFloat(dx[i], PositionScale), base.y + Quantize::Fixed16ToFloat(dy[i], PositionScale),
+            base.z + Quantize::Fixed16ToFloat(dz[i], PositionScale)};
+    }
+
+    const int16_t* ax = columns.Get<AxisX>() + begin;
+    const int16_t* ay = columns.Get<AxisY>() + begin;
+    const int16_t* az = columns.Get<AxisZ>() + begin;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        DecodedAxes[i] = {Quantize::Snorm16ToFloat(ax[i]), Quantize::Snorm16ToFloat(ay[i]), Quantize::Snorm16ToFloat(az[i])};
+    }
+
+    Quantize::Angle16ToDegrees(columns.Get<Angle>() + begin, DecodedDegrees.data(), count);
+
+    const uint16_t* widths = columns.Get<Width>() + begin;
+    const uint16_t* heights = columns.Get<Height>() + begin;
+    const uint16_t* lengths = columns.Get<Length>() + begin;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        DecodedSizes[i] = {Quantize::HalfToFloat(widths[i]), Quantize::HalfToFloat(heights[i]), Quantize::HalfToFloat(lengths[i])};
+    }
+
+    CubeColumns::DrawRows(DecodedPositions.data(), DecodedAxes.data(), DecodedDegrees.data(), DecodedSizes.data(), columns.Get<CubeColor>() + begin,
+        columns.Get<WiresColor>() + begin, columns.Get<Importance>() + begin, count);
+}
@@ -0,0 +1,217 @@
+/*******************************************************************************************
+*
+*   Allocators for the memory backing the command queues.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "QueueAllocator.h"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+QueueAllocator& QueueAllocator::GetDefault()
+{
+    // Never destroyed, since queues owned by globals (or by statics constructed before this) can still free through it
+    // after main returns
+    static SystemQueueAllocator* allocator = new SystemQueueAllocator;
+    return *allocator;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// PagePoolQueueAllocator
+//////////////////////////////////////////////////////////////////////////
+
+PagePoolQueueAllocator::~PagePoolQueueAllocator()
+{
+    for (std::vector<void*>& blocks : FreeBlocks)
+    {
+        for (void* ptr : blocks)
+        {
+            details::AlignedFree(ptr);
+        }
+    }
+}
+
+int PagePoolQueueAllocator::GetSizeClass(size_t bytes)
+{
+    int sizeClass = 0;
+    size_t blockSize = MinBlockSize;
+    while (blockSize < bytes)
+    {
+        blockSize *= 2;
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+void* PagePoolQueueAllocator::Allocate(size_t bytes)
+{
+    const int sizeClass = GetSizeClass(bytes);
+    if (sizeClass >= NumSizeClasses)
+    {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard lock(Mtx);
+        std::vector<void*>& blocks = FreeBlocks[sizeClass];
+        if (!blocks.empty())
+        {
+            void* ptr = blocks.back();
+            blocks.pop_back();
+            CachedBytes -= MinBlockSize << sizeClass;
+            return ptr;
+        }
+    }
+
+    return details::AlignedAlloc(MinBlockSize << sizeClass);
+}
+
+size_t PagePoolQueueAllocator::GetUsableSize(size_t bytes) const
+{
+    const int sizeClass = GetSizeClass(bytes);
+    return sizeClass < NumSizeClasses ? MinBlockSize << sizeClass : bytes;
+}
+
+void PagePoolQueueAllocator::Free(void* ptr, size_t bytes)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    const int sizeClass = GetSizeClass(bytes);
+    const size_t blockSize = MinBlockSize << sizeClass;
+
+    {
+        std::lock_guard lock(Mtx);
+        if (CachedBytes + blockSize <= MaxCachedBytes)
+        {
+            FreeBlocks[sizeClass].push_back(ptr);
+            CachedBytes += blockSize;
+            return;
+        }
+    }
+
+    details::AlignedFree(ptr);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// VirtualMemoryQueueAllocator
+//////////////////////////////////////////////////////////////////////////
+
+VirtualMemoryQueueAllocator::VirtualMemoryQueueAllocator(size_t reserveBytes)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    PageSize = info.dwPageSize;
+#else
+    PageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    ReserveBytes = details::RoundUpToMultipleOf(reserveBytes, PageSize);
+}
+
+void* VirtualMemoryQueueAllocator::Allocate(size_t bytes)
+{
+    if (bytes > ReserveBytes)
+    {
+        return nullptr;
+    }
+
+#if defined(_WIN32)
+    void* ptr = VirtualAlloc(nullptr, ReserveBytes, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* ptr = mmap(nullptr, ReserveBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED)
+    {
+        ptr = nullptr;
+    }
+#endif
+
+    if (ptr && !Commit(ptr, 0, bytes))
+    {
+        Free(ptr, 0);
+        return nullptr;
+    }
+
+    return ptr;
+}
+
+void VirtualMemoryQueueAllocator::Free(void* ptr, [[maybe_unused]] size_t bytes)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, ReserveBytes);
+#endif
+}
+
+bool VirtualMemoryQueueAllocator::TryResize(void* ptr, size_t oldBytes, size_t newBytes)
+{
+    if (newBytes > ReserveBytes)
+    {
+        return false;
+    }
+
+    if (newBytes > oldBytes)
+    {
+        return Commit(ptr, oldBytes, newBytes);
+    }
+
+    Decommit(ptr, newBytes, oldBytes);
+    return true;
+}
+
+bool VirtualMemoryQueueAllocator::Commit(void* ptr, size_t fromBytes, size_t toBytes)
+{
+    // Pages that are partially in use are already committed
+    const size_t from = details::RoundUpToMultipleOf(fromBytes, PageSize);
+    const size_t to = details::RoundUpToMultipleOf(toBytes, PageSize);
+    if (to <= from)
+    {
+        return true;
+    }
+
+    char* start = static_cast<char*>(ptr) + from;
+#if defined(_WIN32)
+    return VirtualAlloc(start, to - from, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+    return mprotect(start, to - from, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void VirtualMemoryQueueAllocator::Decommit(void* ptr, size_t fromBytes, size_t toBytes)
+{
+    // Only whole pages past what is still in use
+    const size_t from = details::RoundUpToMultipleOf(fromBytes, PageSize);
+    const size_t to = details::RoundUpToMultipleOf(toBytes, PageSize);
+    if (to <= from)
+    {
+        return;
+    }
+
+    char* start = static_cast<char*>(ptr) + from;
+#if defined(_WIN32)
+    VirtualFree(start, to - from, MEM_DECOMMIT);
+#else
+    madvise(start, to - from, MADV_DONTNEED);
+    mprotect(start, to - from, PROT_NONE);
+#endif
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************************
+*
+*   rlgl render batch, sized from the vertex counts measured in previous frames.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "RenderBatch.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <iterator>
+
+namespace
+{
+    // rlgl's elements are quads, so 4 vertices each
+    constexpr int VerticesPerElement = 4;
+
+#if defined(GRAPHICS_API_OPENGL_ES2)
+    // OpenGL ES2 uses 16 bits indices
+    constexpr int MaxElements = 65536 / VerticesPerElement;
+#else
+    constexpr int MaxElements = 1 << 17;
+#endif
+
+    int RoundPow2(int n)
+    {
+        int res = 1;
+        while (res < n)
+        {
+            res *= 2;
+        }
+        return res;
+    }
+
+}  // namespace
+
+RenderBatch::~RenderBatch()
+{
+    // Unload needs to be called explicitly while the window is still open
+    assert(!Loaded);
+}
+
+void RenderBatch::Unload()
+{
+    if (Loaded)
+    {
+        rlUnloadRenderBatch(Batch);
+        Batch = {};
+        Loaded = false;
+    }
+}
+
+void RenderBatch::Begin()
+{
+    assert(!Active);
+
+    // Size it for the worst of the last frames, with some room to spare
+    const uint32_t peakVertices = *std::max_element(std::begin(History), std::end(History));
+    const int wantedElements = std::clamp(RoundPow2(static_cast<int>(peakVertices + peakVertices / 4) / VerticesPerElement), RL_DEFAULT_BATCH_BUFFER_ELEMENTS, MaxElements);
+
+    // Only shrink if it's way bigger than needed, so we don't keep reallocating
+    if (!Loaded || wantedElements > NumElements || wantedElements * 4 <= NumElements)
+    {
+        Unload();
+        Batch = rlLoadRenderBatch(NumBuffers, wantedElements);
+        NumElements = wantedElements;
+        Loaded = true;
+    }
+
+    rlSetRenderBatchActive(&Batch);
+    Active = this;
+    LastDepth = Batch.currentDepth;
+    CurrStats = {};
+    CurrStats.Capacity = static_cast<uint32_t>(NumElements * VerticesPerElement);
+}
+
+void RenderBatch::End()
+{
+    assert(Active == this);
+    CheckFlush();
+
+    // This flushes our batch, and sets rlgl's default one as active again
+    rlSetRenderBatchActive(nullptr);
+    Active = nullptr;
+    if (CurrStats.Vertices)
+    {
+        CurrStats.Flushes++;
+    }
+
+    History[HistoryIndex] = CurrStats.Vertices;
+    HistoryIndex = (HistoryIndex + 1) % HistorySize;
+    LastStats = CurrStats;
+}
+
+void RenderBatch::Reserve(int numVertices)
+{
+    if (!Active)
+    {
+        rlCheckRenderBatchLimit(numVertices);
+        return;
+    }
+
+    Active->CheckFlush();
+    if (rlCheckRenderBatchLimit(numVertices))
+    {
+        Active->CurrStats.Flushes++;
+    }
+    Active->LastDepth = Active->Batch.currentDepth;
+    Active->CurrStats.Vertices += static_cast<uint32_t>(numVertices);
+}
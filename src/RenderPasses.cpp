@@ -0,0 +1,46 @@
+/*******************************************************************************************
+*
+*   Render passes that can be added with RenderQueue::AddPass.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "RenderPasses.h"
+
+void CullRenderPass::Run(RenderPassContext& ctx)
+{
+    if (ctx.Views.empty())
+    {
+        return;
+    }
+
+    // A view that doesn't cull sees everything
+    for (const RenderView& view : ctx.Views)
+    {
+        if (!view.Cull)
+        {
+            return;
+        }
+    }
+
+    std::erase_if(ctx.Cmds, [&ctx](const RenderPassCmd& cmd)
+    {
+        if (!cmd.HasBounds)
+        {
+            return false;
+        }
+
+        for (const CameraSnapshot& camera : ctx.Cameras)
+        {
+            if (camera.ViewFrustum.IsSphereVisible(cmd.Position, cmd.Radius))
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+}
@@ -11,23 +11,824 @@
 
 #include "RenderQueue.h"
 #include "rlgl.h"
+#include "raymath.h"
 
-// The camera should not really be controlled by this code, but it's for simplicity
-extern Camera3D camera;
+#include <bit>
+#include <chrono>
+#include <limits>
+#include <stdio.h>
+#include <string_view>
+
+RenderGroup RenderQueue::AddGroup(const RenderGroupDesc& desc)
+{
+    RenderGroup group{static_cast<uint32_t>(Groups.size())};
+    Groups.push_back(std::make_unique<GroupData>());
+    for (QueueSet& set : QSet)
+    {
+        set.Groups.push_back(std::make_unique<GroupQueue>());
+    }
+
+    GroupOrder.push_back(group.Index);
+    SetGroupDesc(group, desc);
+    return group;
+}
+
+void RenderQueue::SetGroupDesc(RenderGroup group, const RenderGroupDesc& desc)
+{
+    Groups[group.Index]->Desc = desc;
+    for (QueueSet& set : QSet)
+    {
+        ConfigureQueue(set, set.Groups[group.Index]->Q, desc.Allocator);
+        set.Groups[group.Index]->Q.SetTypeGrouping(desc.SortMode == RenderSortMode::Type);
+    }
+
+    // stable_sort, so groups with the same priority keep the order they were added in
+    std::stable_sort(GroupOrder.begin(), GroupOrder.end(), [this](uint32_t a, uint32_t b)
+    {
+        return Groups[a]->Desc.Priority < Groups[b]->Desc.Priority;
+    });
+}
+
+void RenderQueue::SetMemoryBudget(size_t setBytes, uint32_t queueBytes)
+{
+    QueueMaxCapacity = queueBytes;
+    // With a budget, memory a queue holds on to is memory other queues can't use, so give it back sooner
+    QueueSizing = {};
+    if (setBytes || queueBytes)
+    {
+        QueueSizing.ShrinkAfterFrames = 8;
+    }
+
+    for (QueueSet& set : QSet)
+    {
+        set.Budget.SetMaxBytes(setBytes);
+        ConfigureQueues(set);
+    }
+}
+
+void RenderQueue::SetQueueAllocator(QueueAllocator* allocator)
+{
+    QueueAlloc = allocator;
+    for (QueueSet& set : QSet)
+    {
+        set.Setup.SetAllocator(allocator);
+        ConfigureQueues(set);
+    }
+}
+
+size_t RenderQueue::AddPass(std::unique_ptr<RenderPass> pass)
+{
+    if (!PassWorkers)
+    {
+        PassWorkers = std::make_unique<WorkerPool>(NumPassWorkers);
+    }
+
+    Passes.push_back(std::move(pass));
+    PassStats.resize(Passes.size());
+    PublishedPassStats.resize(Passes.size());
+    return Passes.size() - 1;
+}
+
+void RenderQueue::RunPasses(GroupQueue& groupQ, int groupIndex)
+{
+    const RenderGroupDesc& desc = Groups[groupIndex]->Desc;
+    groupQ.PassStats.assign(Passes.size(), {});
+    groupQ.UsePassCmds = false;
+    groupQ.PassesReorder = false;
+    bool prepared = false;
+
+    for (size_t i = 0; i < Passes.size(); i++)
+    {
+        RenderPass& pass = *Passes[i];
+        if (!pass.AppliesTo(desc))
+        {
+            continue;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Only groups that have passes pay for building the list, which is then charged to the first pass
+        if (!prepared)
+        {
+            prepared = true;
+            groupQ.PassCmds.clear();
+            // The infos and the blocks are in the same order as the commands, so we can walk all of them at the same time.
+            // The blocks are done recording by now, so their bounds are final.
+            size_t infoIndex = 0;
+            size_t blockIndex = 0;
+            groupQ.Q.ForEachRef([&](RenderCmdQueue::Ref cmd)
+            {
+                RenderPassCmd& entry = groupQ.PassCmds.emplace_back();
+                entry.Cmd = cmd;
+                if (infoIndex < groupQ.Infos.size() && groupQ.Infos[infoIndex].Cmd.Pos == cmd.Pos)
+                {
+                    const CmdInfo& info = groupQ.Infos[infoIndex++];
+                    entry.HasBounds = true;
+                    entry.Position = info.Position;
+                    entry.Radius = info.Radius;
+                    entry.StateKey = info.StateKey;
+                    entry.Importance = info.Importance;
+                }
+                else if (blockIndex < groupQ.BlockCmds.size() && groupQ.BlockCmds[blockIndex].Cmd.Pos == cmd.Pos)
+                {
+                    entry.IsBlock = true;
+                    entry.HasBounds = GetBlockSphere(*groupQ.BlockCmds[blockIndex++].Block, entry.Position, entry.Radius);
+                }
+            });
+
+            groupQ.PassViews.clear();
+            groupQ.PassCameras.clear();
+            if (desc.CameraMode == RenderCameraMode::Mode3D)
+            {
+                for (const GroupView& view : groupQ.Views)
+                {
+                    groupQ.PassViews.push_back(view.View);
+                    groupQ.PassCameras.push_back(view.Camera);
+                }
+            }
+        }
+
+        const size_t numBefore = groupQ.PassCmds.size();
+        RenderPassContext ctx{
+            .Group = {static_cast<uint32_t>(groupIndex)},
+            .Desc = desc,
+            .Q = groupQ.Q,
+            .Views = groupQ.PassViews,
+            .Cameras = groupQ.PassCameras,
+            .Cmds = groupQ.PassCmds};
+        pass.Run(ctx);
+        groupQ.UsePassCmds = groupQ.UsePassCmds || pass.Reorders() || pass.Drops();
+        groupQ.PassesReorder = groupQ.PassesReorder || pass.Reorders();
+
+        RenderPassStats& stats = groupQ.PassStats[i];
+        stats.Ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        stats.NumGroups = 1;
+        stats.NumDropped = numBefore > groupQ.PassCmds.size() ? static_cast<uint32_t>(numBefore - groupQ.PassCmds.size()) : 0;
+    }
+}
+
+void RenderQueue::ConfigureQueues(QueueSet& set)
+{
+    for (size_t i = 0; i < set.Groups.size(); i++)
+    {
+        ConfigureQueue(set, set.Groups[i]->Q, Groups[i]->Desc.Allocator);
+    }
+    for (std::unique_ptr<RenderCmdBlock>& secondary : set.Secondaries)
+    {
+        ConfigureQueue(set, secondary->Q, nullptr);
+    }
+}
+
+bool RenderQueue::SaveQueueProfile(const char* fileName) const
+{
+    // Both sets see the same kind of frames, so take the biggest of the two
+    auto predicted = [this](auto&& getQ)
+    {
+        return std::max(getQ(QSet[0]).GetPredictedCapacity(), getQ(QSet[1]).GetPredictedCapacity());
+    };
+
+    std::string text = std::format("setup {}\n", predicted([](const QueueSet& set) -> const RenderCmdQueue& { return set.Setup; }));
+
+    RenderCmdQueue::SizeType secondaryCapacity = 0;
+    for (const QueueSet& set : QSet)
+    {
+        for (const std::unique_ptr<RenderCmdBlock>& secondary : set.Secondaries)
+        {
+            secondaryCapacity = std::max(secondaryCapacity, secondary->Q.GetPredictedCapacity());
+        }
+    }
+    text += std::format("secondaries {} {}\n", PeakSecondaries, secondaryCapacity);
+
+    for (size_t i = 0; i < Groups.size(); i++)
+    {
+        text += std::format("group {} {}\n", predicted([i](const QueueSet& set) -> const RenderCmdQueue& { return set.Groups[i]->Q; }), Groups[i]->Desc.Name);
+    }
+
+    return SaveFileText(fileName, text.data());
+}
+
+bool RenderQueue::LoadQueueProfile(const char* fileName)
+{
+    if (!FileExists(fileName))
+    {
+        return false;
+    }
+
+    char* text = LoadFileText(fileName);
+    if (!text)
+    {
+        return false;
+    }
+
+    auto warmUp = [](RenderCmdQueue& q, unsigned long long capacity)
+    {
+        if (q.Reserve(static_cast<RenderCmdQueue::SizeType>(std::min<unsigned long long>(capacity, std::numeric_limits<RenderCmdQueue::SizeType>::max()))))
+        {
+            q.Prefault();
+        }
+    };
+
+    std::string_view remaining = text;
+    while (!remaining.empty())
+    {
+        const size_t end = std::min(remaining.find('\n'), remaining.size());
+        const std::string line(remaining.substr(0, end));
+        remaining.remove_prefix(std::min(end + 1, remaining.size()));
+
+        unsigned long long count = 0;
+        unsigned long long capacity = 0;
+        int nameStart = 0;
+        if (sscanf(line.c_str(), "setup %llu", &capacity) == 1)
+        {
+            for (QueueSet& set : QSet)
+            {
+                warmUp(set.Setup, capacity);
+            }
+        }
+        else if (sscanf(line.c_str(), "secondaries %llu %llu", &count, &capacity) == 2)
+        {
+            PeakSecondaries = static_cast<size_t>(count);
+            for (QueueSet& set : QSet)
+            {
+                while (set.Secondaries.size() < count)
+                {
+                    AddSecondary(set);
+                }
+                for (std::unique_ptr<RenderCmdBlock>& secondary : set.Secondaries)
+                {
+                    warmUp(secondary->Q, capacity);
+                }
+            }
+        }
+        else if (sscanf(line.c_str(), "group %llu %n", &capacity, &nameStart) == 1 && nameStart > 0)
+        {
+            const std::string_view name = std::string_view(line).substr(nameStart);
+            for (size_t i = 0; i < Groups.size(); i++)
+            {
+                if (Groups[i]->Desc.Name == name)
+                {
+                    for (QueueSet& set : QSet)
+                    {
+                        warmUp(set.Groups[i]->Q, capacity);
+                    }
+                }
+            }
+        }
+    }
+
+    UnloadFileText(text);
+    return true;
+}
 
 void RenderQueue::Render()
 {
-    UpdateCamera(&camera, CAMERA_PERSPECTIVE);
+    // The passes need to be done with the set before we render it
+    if (PassWorkers)
+    {
+        PassWorkers->Wait();
+        for (RenderPassStats& stats : PassStats)
+        {
+            stats = {};
+        }
+        for (const std::unique_ptr<GroupQueue>& groupQ : RenderSet->Groups)
+        {
+            for (size_t i = 0; i < groupQ->PassStats.size(); i++)
+            {
+                PassStats[i].Ms += groupQ->PassStats[i].Ms;
+                PassStats[i].NumGroups += groupQ->PassStats[i].NumGroups;
+                PassStats[i].NumDropped += groupQ->PassStats[i].NumDropped;
+            }
+        }
+    }
+
+    RenderStart = std::chrono::high_resolution_clock::now();
+    // Start with one level less than what the last frame ended with, so we recover gradually
+    DropLevel = RenderBudgetMs > 0 ? std::max(0, DropLevel - 1) : 0;
+
+    RenderSet->Setup.CallAll();
+    MemoryStats.NumFailedPushes = 0;
+    MemoryStats.UsedBytes = RenderSet->Setup.GetUsedCapacity();
+    RenderSet->Setup.Clear();
+
+    for (uint32_t index : GroupOrder)
+    {
+        GroupData& group = *Groups[index];
+        GroupQueue& groupQ = *RenderSet->Groups[index];
+        const RenderGroupDesc& desc = group.Desc;
+        auto start = std::chrono::high_resolution_clock::now();
+
+        GroupImportance = desc.Importance;
+        NumDropped = 0;
+        UpdateDropLevel();
+        if (ShouldDrop(RenderImportance::Required))
+        {
+            // Not even the target is cleared, so whatever was there last time is shown
+            group.Stats = {};
+            group.Stats.NumCommands = groupQ.Q.GetNumElements();
+            group.Stats.NumDropped = groupQ.Q.GetNumElements();
+            group.Stats.NumFailedPushes = groupQ.Q.GetNumFailedPushes();
+            MemoryStats.NumFailedPushes += group.Stats.NumFailedPushes;
+            MemoryStats.UsedBytes += GetUsedBytes(groupQ);
+            groupQ.Q.Clear();
+            groupQ.Infos.clear();
+            groupQ.BlockCmds.clear();
+            groupQ.Cubes.Clear();
+            groupQ.CompactCubes.Clear();
+            continue;
+        }
+
+        if (desc.Target.id)
+        {
+            BeginTextureMode(desc.Target);
+        }
+
+        if (desc.Clear)
+        {
+            ClearBackground(desc.ClearColor);
+        }
+
+        NumCulled = 0;
+        group.Batch.Begin();
+        if (desc.CameraMode == RenderCameraMode::Mode3D)
+        {
+            const int targetWidth = desc.Target.id ? desc.Target.texture.width : GetRenderWidth();
+            const int targetHeight = desc.Target.id ? desc.Target.texture.height : GetRenderHeight();
+            for (const GroupView& view : groupQ.Views)
+            {
+                RenderGroupView(groupQ, desc.SortMode, view, targetHeight);
+            }
+            rlViewport(0, 0, targetWidth, targetHeight);
+        }
+        else if (desc.CameraMode == RenderCameraMode::Mode2D)
+        {
+            BeginMode2D(groupQ.Cam2D);
+                RenderGroupCmds(groupQ, desc.SortMode, {});
+            EndMode2D();
+        }
+        else
+        {
+            RenderGroupCmds(groupQ, desc.SortMode, {});
+        }
+        group.Batch.End();
+
+        if (desc.Target.id)
+        {
+            EndTextureMode();
+        }
+
+        group.Stats.Batch = group.Batch.GetStats();
+        group.Stats.NumCommands = groupQ.Q.GetNumElements();
+        group.Stats.NumViews = desc.CameraMode == RenderCameraMode::Mode3D ? static_cast<uint32_t>(groupQ.Views.size()) : 1;
+        group.Stats.NumCulled = NumCulled;
+        group.Stats.NumDropped = NumDropped;
+        group.Stats.NumFailedPushes = groupQ.Q.GetNumFailedPushes();
+        MemoryStats.NumFailedPushes += group.Stats.NumFailedPushes;
+        group.Stats.RenderMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        MemoryStats.UsedBytes += GetUsedBytes(groupQ);
+        groupQ.Q.Clear();
+        groupQ.Infos.clear();
+        groupQ.BlockCmds.clear();
+        groupQ.Cubes.Clear();
+        groupQ.CompactCubes.Clear();
+    }
+
+    // Release our references to any blocks this set used, and recycle the secondaries
+    RenderSet->Blocks.clear();
+    for (size_t i = 0; i < RenderSet->NumSecondaries; i++)
+    {
+        MemoryStats.NumFailedPushes += RenderSet->Secondaries[i]->Q.GetNumFailedPushes();
+        MemoryStats.UsedBytes += RenderSet->Secondaries[i]->Q.GetUsedCapacity();
+        RenderSet->Secondaries[i]->Q.Clear();
+        RenderSet->Secondaries[i]->Blocks.clear();
+        RenderSet->Secondaries[i]->NumBounded = 0;
+    }
+    PeakSecondaries = std::max(PeakSecondaries, RenderSet->NumSecondaries);
+    RenderSet->NumSecondaries = 0;
+    MemoryStats.Capacity = RenderSet->Budget.GetUsed();
+
+    // The render set holds the commands of the epoch before the one being recorded
+    CompletedEpoch.store(Epoch - 1, std::memory_order_release);
+}
+
+void RenderQueue::UpdateDropLevel()
+{
+    if (RenderBudgetMs <= 0)
+    {
+        return;
+    }
+
+    const float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - RenderStart).count();
+    int level = 0;
+    if (elapsedMs > RenderBudgetMs * 1.5f)
+    {
+        level = 3;
+    }
+    else if (elapsedMs > RenderBudgetMs * 1.25f)
+    {
+        level = 2;
+    }
+    else if (elapsedMs > RenderBudgetMs)
+    {
+        level = 1;
+    }
+
+    // Never goes down during a frame
+    DropLevel = std::max(DropLevel, level);
+}
+
+void RenderQueue::SetViews(RenderGroup group, std::span<const RenderView> views)
+{
+    RenderQueue& rq = RenderQueue::Get();
+    const RenderGroupDesc& desc = rq.Groups[group.Index]->Desc;
+    assert(desc.CameraMode == RenderCameraMode::Mode3D);
+
+    // Reading the render size from the logic side is fine, since it only changes while the threads are synchronized
+    const float targetWidth = static_cast<float>(desc.Target.id ? desc.Target.texture.width : GetRenderWidth());
+    const float targetHeight = static_cast<float>(desc.Target.id ? desc.Target.texture.height : GetRenderHeight());
+
+    std::vector<GroupView>& dst = rq.LogicSet->Groups[group.Index]->Views;
+    dst.resize(views.size());
+    for (size_t i = 0; i < views.size(); i++)
+    {
+        GroupView& view = dst[i];
+        view.View = views[i];
+        if (view.View.Viewport.width <= 0 || view.View.Viewport.height <= 0)
+        {
+            view.View.Viewport = {0, 0, targetWidth, targetHeight};
+        }
+        view.Camera = CameraSnapshot::Make(view.View.Camera, view.View.Viewport.width / view.View.Viewport.height);
+    }
+}
+
+void RenderQueue::RenderGroupView(GroupQueue& group, RenderSortMode sortMode, const GroupView& groupView, int targetHeight)
+{
+    const RenderView& view = groupView.View;
+    const Rectangle& viewport = view.Viewport;
+    const int x = static_cast<int>(viewport.x);
+    const int y = static_cast<int>(viewport.y);
+    const int width = static_cast<int>(viewport.width);
+    const int height = static_cast<int>(viewport.height);
+
+    // Flushes anything drawn with the previous view, since rlgl only applies the matrices and viewport when it draws
+    rlDrawRenderBatchActive();
+
+    // Viewport is specified from the bottom-left corner. The scissor keeps the clear inside the viewport.
+    rlViewport(x, targetHeight - (y + height), width, height);
+    BeginScissorMode(x, y, width, height);
+    if (view.Clear)
+    {
+        ClearBackground(view.ClearColor);
+    }
+
+    // The snapshot was built by the logic side with the viewport's aspect ratio, so we just load its matrices
+    const CameraSnapshot& camera = groupView.Camera;
+    camera.Begin();
+    CullFrustum = view.Cull ? &camera.ViewFrustum : nullptr;
+    RenderGroupCmds(group, sortMode, camera.Camera.position);
+    CullFrustum = nullptr;
 
-    // Render 3D group
-    BeginMode3D(camera);
-		RenderSet->Q[static_cast<int>(RenderGroup::World)].CallAll();
-		RenderSet->Q[static_cast<int>(RenderGroup::World)].Clear();
     EndMode3D();
+    EndScissorMode();
+}
+
+bool RenderQueue::GetBlockSphere(const RenderCmdBlock& block, Vector3& center, float& radius)
+{
+    // Only blocks where all commands have bounds can be culled
+    if (block.NumBounded == 0 || block.NumBounded != block.Q.GetNumElements())
+    {
+        return false;
+    }
+
+    center = {(block.BoundsMin.x + block.BoundsMax.x) / 2, (block.BoundsMin.y + block.BoundsMax.y) / 2, (block.BoundsMin.z + block.BoundsMax.z) / 2};
+    radius = GetCubeRadius(block.BoundsMax.x - block.BoundsMin.x, block.BoundsMax.y - block.BoundsMin.y, block.BoundsMax.z - block.BoundsMin.z);
+    return true;
+}
+
+bool RenderQueue::IsBlockVisible(const RenderCmdBlock& block)
+{
+    Vector3 center;
+    float radius;
+    if (!CullFrustum || !GetBlockSphere(block, center, radius))
+    {
+        return true;
+    }
+
+    if (CullFrustum->IsSphereVisible(center, radius))
+    {
+        return true;
+    }
+
+    NumCulled++;
+    return false;
+}
+
+namespace
+{
+    /*!
+     * Maps a float to an uint32_t with the same ordering, so distances can be sorted with the same integer keys as
+     * the state keys. Positive floats just need the sign bit set, and negative ones need all bits flipped.
+     */
+    uint32_t DistanceSortKey(float value)
+    {
+        const uint32_t bits = std::bit_cast<uint32_t>(value);
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+} // namespace
+
+void RenderQueue::RenderGroupCmds(GroupQueue& group, RenderSortMode sortMode, const Vector3& viewPos)
+{
+    // If the passes reordered the commands, that's the order they are rendered in. If they only dropped some, the list is
+    // still in queue order, so without sorting, it can be rendered as-is.
+    if (group.UsePassCmds && (group.PassesReorder || sortMode == RenderSortMode::None))
+    {
+        RenderPassCmds(group);
+        return;
+    }
+
+    if (sortMode == RenderSortMode::Type)
+    {
+        RenderGroupCmdsByType(group);
+        return;
+    }
+
+    if (!group.UsePassCmds && ((sortMode == RenderSortMode::None && !CullFrustum) || group.Infos.empty()))
+    {
+        if (RenderBudgetMs <= 0)
+        {
+            group.Q.CallAll();
+        }
+        else
+        {
+            // Commands without importance of their own can only be dropped along with the group, so once the group is
+            // dropped, we can stop
+            NumDropped += group.Q.CallAllChunked(BudgetCheckInterval, [this]()
+            {
+                UpdateDropLevel();
+                return !ShouldDrop(RenderImportance::Required);
+            });
+        }
+        return;
+    }
+
+    // Works with both a CmdInfo and a RenderPassCmd
+    auto getKey = [sortMode, &viewPos](const auto& info) -> uint32_t
+    {
+        // Converting the state key to float would merge keys above 2^24 (e.g texture ids in the upper bits)
+        if (sortMode == RenderSortMode::State)
+        {
+            return info.StateKey;
+        }
+
+        const float dx = info.Position.x - viewPos.x;
+        const float dy = info.Position.y - viewPos.y;
+        const float dz = info.Position.z - viewPos.z;
+        const float distSqr = dx * dx + dy * dy + dz * dz;
+        return DistanceSortKey(sortMode == RenderSortMode::FrontToBack ? distSqr : -distSqr);
+    };
+
+    // Sorts and runs the commands collected so far
+    auto flush = [this, &group]()
+    {
+        std::stable_sort(SortEntries.begin(), SortEntries.end(), [](const SortEntry& a, const SortEntry& b)
+        {
+            return a.Key < b.Key;
+        });
 
-    // Render UI group
-    RenderSet->Q[static_cast<int>(RenderGroup::UI)].CallAll();
-    RenderSet->Q[static_cast<int>(RenderGroup::UI)].Clear();
+        for (const SortEntry& entry : SortEntries)
+        {
+            group.Q.CallAt(entry.Cmd);
+        }
+        SortEntries.clear();
+    };
+
+    // Drops or culls a command with sort info, and otherwise runs it or collects it for sorting
+    auto addSortable = [&](RenderCmdQueue::Ref cmd, const auto& info)
+    {
+        if (ShouldDrop(info.Importance))
+        {
+            NumDropped++;
+        }
+        else if (CullFrustum && !CullFrustum->IsSphereVisible(info.Position, info.Radius))
+        {
+            NumCulled++;
+        }
+        else if (sortMode == RenderSortMode::None)
+        {
+            group.Q.CallAt(cmd);
+        }
+        else
+        {
+            SortEntries.push_back({cmd, getKey(info)});
+        }
+    };
+
+    uint32_t count = 0;
+    if (group.UsePassCmds)
+    {
+        // What the passes left, still in queue order
+        for (const RenderPassCmd& entry : group.PassCmds)
+        {
+            if ((count++ % BudgetCheckInterval) == 0)
+            {
+                UpdateDropLevel();
+            }
+
+            if (entry.HasBounds && !entry.IsBlock)
+            {
+                addSortable(entry.Cmd, entry);
+            }
+            else
+            {
+                // Same as below, nothing can move across commands without sort info
+                flush();
+                RunPassCmd(group, entry);
+            }
+        }
+
+        flush();
+        return;
+    }
+
+    // The infos are in the same order as the commands, so we can walk both at the same time
+    size_t infoIndex = 0;
+    group.Q.ForEachRef([&](RenderCmdQueue::Ref cmd)
+    {
+        if ((count++ % BudgetCheckInterval) == 0)
+        {
+            UpdateDropLevel();
+        }
+
+        if (infoIndex < group.Infos.size() && group.Infos[infoIndex].Cmd.Pos == cmd.Pos)
+        {
+            addSortable(cmd, group.Infos[infoIndex++]);
+        }
+        else
+        {
+            // Commands without sort info can't be moved, nor can other commands move across them
+            flush();
+            if (ShouldDrop(RenderImportance::Required))
+            {
+                NumDropped++;
+            }
+            else
+            {
+                group.Q.CallAt(cmd);
+            }
+        }
+    });
+
+    flush();
+}
+
+void RenderQueue::RunPassCmd(GroupQueue& group, const RenderPassCmd& cmd)
+{
+    if (ShouldDrop(cmd.Importance))
+    {
+        NumDropped++;
+    }
+    else if (cmd.HasBounds && CullFrustum && !CullFrustum->IsSphereVisible(cmd.Position, cmd.Radius))
+    {
+        NumCulled++;
+    }
+    else
+    {
+        group.Q.CallAt(cmd.Cmd);
+    }
+}
+
+void RenderQueue::RenderPassCmds(GroupQueue& group)
+{
+    uint32_t count = 0;
+    for (const RenderPassCmd& cmd : group.PassCmds)
+    {
+        if ((count++ % BudgetCheckInterval) == 0)
+        {
+            UpdateDropLevel();
+        }
+
+        RunPassCmd(group, cmd);
+    }
+}
+
+std::span<const uint32_t> RenderQueue::GetVisibleCubeRows(const Vector3* positions, const Vector3* sizes, const RenderImportance* importances, uint32_t count)
+{
+    VisibleRows.clear();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if ((i % BudgetCheckInterval) == 0)
+        {
+            UpdateDropLevel();
+        }
+
+        if (importances && ShouldDrop(importances[i]))
+        {
+            NumDropped++;
+        }
+        else if (CullFrustum && !CullFrustum->IsSphereVisible(positions[i], GetCubeRadius(sizes[i].x, sizes[i].y, sizes[i].z)))
+        {
+            NumCulled++;
+        }
+        else
+        {
+            VisibleRows.push_back(i);
+        }
+    }
+
+    return VisibleRows;
+}
+
+void RenderQueue::RenderGroupCmdsByType(GroupQueue& group)
+{
+    if (group.UsePassCmds)
+    {
+        RenderPassCmdsByType(group);
+        return;
+    }
+
+    if (!CullFrustum && group.Infos.empty() && RenderBudgetMs <= 0)
+    {
+        group.Q.CallAllGrouped();
+        return;
+    }
+
+    // The infos are sorted by position in the queue, since they are pushed in the same order as the commands
+    uint32_t count = 0;
+    group.Q.CallAllGroupedIf([&](RenderCmdQueue::Ref cmd)
+    {
+        if ((count++ % BudgetCheckInterval) == 0)
+        {
+            UpdateDropLevel();
+        }
+
+        auto it = std::lower_bound(group.Infos.begin(), group.Infos.end(), cmd.Pos, [](const CmdInfo& info, RenderCmdQueue::SizeType pos)
+        {
+            return info.Cmd.Pos < pos;
+        });
+
+        const bool hasInfo = it != group.Infos.end() && it->Cmd.Pos == cmd.Pos;
+        if (ShouldDrop(hasInfo ? it->Importance : RenderImportance::Required))
+        {
+            NumDropped++;
+            return false;
+        }
+        else if (hasInfo && CullFrustum && !CullFrustum->IsSphereVisible(it->Position, it->Radius))
+        {
+            NumCulled++;
+            return false;
+        }
+
+        return true;
+    });
+}
+
+void RenderQueue::RenderPassCmdsByType(GroupQueue& group)
+{
+    // Passes that replace commands push the new ones at the end of the queue, so the list isn't necessarily sorted by
+    // position
+    group.PassCmdsByPos.clear();
+    for (const RenderPassCmd& cmd : group.PassCmds)
+    {
+        group.PassCmdsByPos.push_back(&cmd);
+    }
+    std::sort(group.PassCmdsByPos.begin(), group.PassCmdsByPos.end(), [](const RenderPassCmd* a, const RenderPassCmd* b)
+    {
+        return a->Cmd.Pos < b->Cmd.Pos;
+    });
+
+    uint32_t count = 0;
+    group.Q.CallAllGroupedIf([&](RenderCmdQueue::Ref cmd)
+    {
+        if ((count++ % BudgetCheckInterval) == 0)
+        {
+            UpdateDropLevel();
+        }
+
+        auto it = std::lower_bound(group.PassCmdsByPos.begin(), group.PassCmdsByPos.end(), cmd.Pos, [](const RenderPassCmd* entry, RenderCmdQueue::SizeType pos)
+        {
+            return entry->Cmd.Pos < pos;
+        });
+
+        // Not in the list means a pass dropped it, and the pass counts it
+        if (it == group.PassCmdsByPos.end() || (*it)->Cmd.Pos != cmd.Pos)
+        {
+            return false;
+        }
+
+        const RenderPassCmd& entry = **it;
+        if (ShouldDrop(entry.Importance))
+        {
+            NumDropped++;
+            return false;
+        }
+        else if (entry.HasBounds && CullFrustum && !CullFrustum->IsSphereVisible(entry.Position, entry.Radius))
+        {
+            NumCulled++;
+            return false;
+        }
+
+        return true;
+    });
 }
 
 // Helper code
@@ -38,16 +839,153 @@ namespace
     RenderCmdQueue::Ref PushString(RenderCmdQueue& q, std::string_view str)
     {
         // +1, to make it null terminated
-        RenderCmdQueue::Ref ref = q.OobPushEmpty<uint8_t>(static_cast<uint8_t>(str.size() + 1));
+        RenderCmdQueue::Ref ref = q.OobPushEmpty<char>(str.size() + 1);
+        if (!ref.IsSet())
+        {
+            return ref;
+        }
+
         uint8_t* ptr = q.OobAt(ref);
         memcpy(ptr, str.data(), str.size());
         ptr[str.size()] = 0;
         return ref;
     }
 
+    // A DrawCubeEx command.
+    // When the group runs commands grouped by type, all the cubes are drawn first and then all the wireframes, so rlgl
+    // doesn't need a new draw call for every cube because of switching between triangles and lines.
+    struct DrawCubeExCmd
+    {
+        Vector3 Position;
+        float Degrees;
+        Vector3 RotationAxis;
+        float Width;
+        float Height;
+        float Length;
+        Color CubeColor;
+        Color WiresColor;
+
+        void Draw(bool wires) const
+        {
+            RenderBatch::Reserve(wires ? 24 : 36);
+            ::rlPushMatrix();
+                ::rlTranslatef(Position.x, Position.y, Position.z);
+                ::rlRotatef(Degrees, RotationAxis.x, RotationAxis.y, RotationAxis.z);
+                if (wires)
+                {
+                    ::DrawCubeWires({}, Width, Height, Length, WiresColor);
+                }
+                else
+                {
+                    ::DrawCube({}, Width, Height, Length, CubeColor);
+                }
+            ::rlPopMatrix();
+        }
+
+        void operator()(RenderCmdQueue&) const
+        {
+            Draw(false);
+            Draw(true);
+        }
+
+        static void CallBatch(RenderCmdQueue&, const RenderCmdQueue::Batch<DrawCubeExCmd>& batch)
+        {
+            for (RenderCmdQueue::SizeType i = 0; i < batch.GetSize(); i++)
+            {
+                batch[i].Draw(false);
+            }
+            for (RenderCmdQueue::SizeType i = 0; i < batch.GetSize(); i++)
+            {
+                batch[i].Draw(true);
+            }
+        }
+    };
+
 }  // namespace
 
 
+void RenderQueue::ExecuteBlock(RenderGroup group, std::shared_ptr<RenderCmdBlock> block)
+{
+    assert(block);
+    RenderCmdBlock* ptr = block.get();
+    if (Recording)
+    {
+        Recording->Blocks.push_back(std::move(block));
+    }
+    else
+    {
+        RenderQueue::Get().LogicSet->Blocks.push_back(std::move(block));
+    }
+
+    // We only capture the raw pointer, since the set (or the parent block) keeps it alive
+    RenderCmdQueue::Ref ref = GetQ(group).Push([ptr, importance = CmdImportance](RenderCmdQueue&)
+    {
+        RenderQueue& rq = RenderQueue::Get();
+        if (ptr->IsValid() && !rq.CheckDropBlock(importance) && rq.IsBlockVisible(*ptr))
+        {
+            ptr->Q.CallAll();
+        }
+    });
+
+    if (ref.IsSet() && !Recording)
+    {
+        RenderQueue::Get().LogicSet->Groups[group.Index]->BlockCmds.push_back({ref, ptr});
+    }
+}
+
+RenderCmdBlock& RenderQueue::AddSecondary(QueueSet& set)
+{
+    set.Secondaries.push_back(std::make_unique<RenderCmdBlock>());
+    set.Secondaries.back()->FrameScoped = true;
+    ConfigureQueue(set, set.Secondaries.back()->Q, nullptr);
+    return *set.Secondaries.back();
+}
+
+RenderCmdBlock& RenderQueue::ExecuteSecondary(RenderGroup group)
+{
+    // Secondaries are frame scoped, so they can't be referenced from a persistent block
+    assert(!Recording);
+
+    QueueSet& set = *RenderQueue::Get().LogicSet;
+    if (set.NumSecondaries == set.Secondaries.size())
+    {
+        RenderQueue::Get().AddSecondary(set);
+    }
+
+    RenderCmdBlock* ptr = set.Secondaries[set.NumSecondaries++].get();
+    RenderCmdQueue::Ref ref = GetQ(group).Push([ptr, importance = CmdImportance](RenderCmdQueue&)
+    {
+        RenderQueue& rq = RenderQueue::Get();
+        if (!rq.CheckDropBlock(importance) && rq.IsBlockVisible(*ptr))
+        {
+            ptr->Q.CallAll();
+        }
+    });
+
+    if (ref.IsSet())
+    {
+        set.Groups[group.Index]->BlockCmds.push_back({ref, ptr});
+    }
+
+    return *ptr;
+}
+
+void RenderQueue::PushDrawText(RenderCmdQueue& q, RenderCmdQueue::Ref textRef, int posX, int posY, int fontSize, Color color)
+{
+    // The queue ran out of memory for the text
+    if (!textRef.IsSet())
+    {
+        return;
+    }
+
+    q.Push([textRef, posX, posY, fontSize, color](RenderCmdQueue& q)
+    {
+        const char* text = reinterpret_cast<const char*>(q.OobAt(textRef));
+        RenderBatch::Reserve(static_cast<int>(strlen(text) * 4));
+        ::DrawText(text, posX, posY, fontSize, color);
+    });
+}
+
 void RenderQueue::DrawText(std::string_view text, int posX, int posY, int fontSize, Color color)
 {
     RenderCmdQueue& q = GetQ(RenderGroup::UI);
@@ -55,9 +993,69 @@ void RenderQueue::DrawText(std::string_view text, int posX, int posY, int fontSi
     //
     // Since we can't capture an std::string (due to the limitations of the container), we can insert it as oob data, capture
     // the Ref insteand, and then get the string data back. This is all done without allocating memory.
-    q.Push([textRef = PushString(q, text), posX, posY, fontSize, color](RenderCmdQueue& q)
+    PushDrawText(q, PushString(q, text), posX, posY, fontSize, color);
+}
+
+void RenderQueue::DrawText(PersistentArena::Ref text, int posX, int posY, int fontSize, Color color)
+{
+    assert(text.IsSet() && text.Ptr[text.Size - 1] == 0);
+    GetQ(RenderGroup::UI).Push([text, posX, posY, fontSize, color](RenderCmdQueue&)
+    {
+        RenderBatch::Reserve(static_cast<int>((text.Size - 1) * 4));
+        ::DrawText(PersistentArena::At<const char>(text), posX, posY, fontSize, color);
+    });
+}
+
+StringId RenderQueue::Intern(std::string_view str)
+{
+    RenderQueue& rq = RenderQueue::Get();
+    return rq.Strings.Intern(str, [&rq](StringId id, std::string_view newStr)
+    {
+        // New string, so send it over to the render side
+        RenderCmdQueue& q = rq.LogicSet->Setup;
+        q.Push([id, strRef = PushString(q, newStr), size = static_cast<uint32_t>(newStr.size())](RenderCmdQueue& q)
+        {
+            RenderQueue::Get().Strings.Register(id, std::string_view(reinterpret_cast<const char*>(q.OobAt(strRef)), size));
+        });
+    });
+}
+
+void RenderQueue::DrawText(StringId text, int posX, int posY, int fontSize, Color color, uint32_t fontId)
+{
+    assert(text.IsSet());
+    RenderQueue& rq = RenderQueue::Get();
+    RenderCmdQueue& q = GetQ(RenderGroup::UI);
+
+    if (rq.TextLayouts.GetNumFonts() == 0)
     {
-        ::DrawText(reinterpret_cast<const char*>(q.OobAt(textRef)), posX, posY, fontSize, color);
+        q.Push([text, posX, posY, fontSize, color](RenderCmdQueue&)
+        {
+            const char* str = RenderQueue::Get().Strings.Resolve(text);
+            RenderBatch::Reserve(static_cast<int>(strlen(str) * 4));
+            ::DrawText(str, posX, posY, fontSize, color);
+        });
+        return;
+    }
+
+    // Queue the laid out glyphs, so the render thread only needs to emit the vertices
+    assert(fontId < rq.TextLayouts.GetNumFonts());
+    RenderCmdQueue::Ref quadsRef;
+    uint32_t count = 0;
+    rq.TextLayouts.Get(text, [&rq, text]() { return rq.Strings.Find(text); }, fontId, fontSize, [&](const GlyphQuad* quads, size_t numQuads)
+    {
+        quadsRef = q.OobPush(quads, numQuads);
+        count = static_cast<uint32_t>(numQuads);
+    });
+
+    if (!quadsRef.IsSet())
+    {
+        return;
+    }
+
+    q.Push([quadsRef, count, posX, posY, color, fontId](RenderCmdQueue& q)
+    {
+        TextLayoutCache::Draw(
+            RenderQueue::Get().TextLayouts.GetFont(fontId), &q.OobAtAs<GlyphQuad>(quadsRef), count, static_cast<float>(posX), static_cast<float>(posY), color);
     });
 }
 
@@ -65,36 +1063,124 @@ void RenderQueue::DrawRectangle(int posX, int posY, int width, int height, Color
 {
     GetQ(RenderGroup::UI).Push([posX, posY, width, height, color](RenderCmdQueue& )
     {
+        RenderBatch::Reserve(4);
         ::DrawRectangle(posX, posY, width, height, color);
     });
 }
 
+void RenderQueue::DrawBatch(UIBatcher& batcher)
+{
+    batcher.Submit(GetQ(RenderGroup::UI));
+}
+
 void RenderQueue::DrawCube(Vector3 position, float width, float height, float length, Color color)
 {
-    GetQ(RenderGroup::World).Push([position, width, height, length, color](RenderCmdQueue& )
+    PushBounded(RenderGroup::World, position, GetCubeRadius(width, height, length), MakeStateKey(rlGetTextureIdDefault(), RL_TRIANGLES), [position, width, height, length, color](RenderCmdQueue& )
     {
+        RenderBatch::Reserve(36);
         ::DrawCube(position, width, height, length, color);
     });
 }
 
 void RenderQueue::DrawCubeWires(Vector3 position, float width, float height, float length, Color color)
 {
-    GetQ(RenderGroup::World).Push([position, width, height, length, color](RenderCmdQueue&)
+    PushBounded(RenderGroup::World, position, GetCubeRadius(width, height, length), MakeStateKey(rlGetTextureIdDefault(), RL_LINES), [position, width, height, length, color](RenderCmdQueue&)
     {
+        RenderBatch::Reserve(24);
         ::DrawCubeWires(position, width, height, length, color);
     });
 }
 
 void RenderQueue::DrawCubeEx(Vector3 position, float degrees, Vector3 rotationAxis, float width, float height, float length, Color color, Color wcolor)
 {
-    GetQ(RenderGroup::World).Push([position, degrees, rotationAxis, width, height, length, color, wcolor](RenderCmdQueue& )
+    // Groups that don't sort get the cube as a row of the group's columns. Sorting needs a command per cube, and blocks
+    // can't reference the frame's columns, so those use DrawCubeExCmd.
+    const RenderSortMode sortMode = GetGroupDesc(RenderGroup::World).SortMode;
+    if (!Recording && (sortMode == RenderSortMode::None || sortMode == RenderSortMode::Type))
+    {
+        GroupQueue& groupQ = *Get().LogicSet->Groups[RenderGroup::World.Index];
+        if (Get().CompactCommands &&
+            CompactCubeColumns::Push(groupQ.Q, groupQ.CompactCubes, position, degrees, rotationAxis, width, height, length, color, wcolor, CmdImportance))
+        {
+            return;
+        }
+
+        CubeColumns::Push(groupQ.Q, groupQ.Cubes, position, degrees, rotationAxis, width, height, length, color, wcolor, CmdImportance);
+        return;
+    }
+
+    // Draws triangles and lines, so the state key is the triangles', which is what most of the vertices are
+    PushBounded(
+        RenderGroup::World, position, GetCubeRadius(width, height, length), MakeStateKey(rlGetTextureIdDefault(), RL_TRIANGLES),
+        DrawCubeExCmd{position, degrees, rotationAxis, width, height, length, color, wcolor});
+}
+
+
+void RenderQueue::DrawCubeRange(const CubeSnapshot& snapshot, uint32_t begin, uint32_t end)
+{
+    assert(snapshot.IsPublished() && begin <= end && end <= snapshot.GetSize());
+    if (Recording && !Recording->FrameScoped)
     {
-        ::rlPushMatrix();
-            ::rlTranslatef(position.x, position.y, position.z);
-            ::rlRotatef(degrees, rotationAxis.x, rotationAxis.y, rotationAxis.z);
-            ::DrawCube({}, width, height, length, color);
-            ::DrawCubeWires({}, width, height, length, wcolor);
-        ::rlPopMatrix();
+        assert(false && "DrawCubeRange can't be recorded into a persistent block");
+        return;
+    }
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    // Keeps the snapshot from being reused until the render thread is done with this frame. Every thread queuing during
+    // the frame stores the same epoch, so it never goes back.
+    snapshot.LastUsedEpoch.store(Get().Epoch, std::memory_order_relaxed);
+
+    const RenderImportance importance = CmdImportance;
+    GetQ(RenderGroup::World).Push([&snapshot, begin, count = end - begin, importance](RenderCmdQueue&)
+    {
+        RenderQueue& rq = RenderQueue::Get();
+        rq.UpdateDropLevel();
+        if (rq.ShouldDrop(importance))
+        {
+            rq.NumDropped += count;
+            return;
+        }
+
+        const auto& columns = snapshot.Columns;
+        CubeColumns::DrawRows(columns.Get<CubeSnapshot::Position>() + begin, columns.Get<CubeSnapshot::RotationAxis>() + begin,
+            columns.Get<CubeSnapshot::Degrees>() + begin, columns.Get<CubeSnapshot::Size>() + begin, columns.Get<CubeSnapshot::CubeColor>() + begin,
+            columns.Get<CubeSnapshot::WiresColor>() + begin, nullptr, count);
     });
 }
 
+CubeSnapshot& RenderQueue::AcquireCubeSnapshot()
+{
+    RenderQueue& rq = Get();
+    const uint64_t completed = rq.CompletedEpoch.load(std::memory_order_acquire);
+
+    std::lock_guard lock(rq.SnapshotsMtx);
+    CubeSnapshot* snapshot = nullptr;
+    for (std::unique_ptr<CubeSnapshot>& candidate : rq.Snapshots)
+    {
+        if (!candidate->Acquired && candidate->LastUsedEpoch.load(std::memory_order_relaxed) <= completed)
+        {
+            snapshot = candidate.get();
+            break;
+        }
+    }
+
+    if (!snapshot)
+    {
+        snapshot = rq.Snapshots.emplace_back(std::make_unique<CubeSnapshot>()).get();
+    }
+
+    snapshot->Columns.Clear();
+    snapshot->Published = false;
+    snapshot->Acquired = true;
+    return *snapshot;
+}
+
+void RenderQueue::ReleaseCubeSnapshot(CubeSnapshot& snapshot)
+{
+    std::lock_guard lock(Get().SnapshotsMtx);
+    snapshot.Acquired = false;
+}
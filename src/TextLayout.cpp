@@ -0,0 +1,100 @@
+/*******************************************************************************************
+*
+*   Text layout, done outside of the render thread.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "TextLayout.h"
+#include "RenderBatch.h"
+#include "rlgl.h"
+
+void TextLayoutCache::Layout(const Font& font, std::string_view text, int fontSize, std::vector<GlyphQuad>& out, int lineSpacing)
+{
+    // Same as raylib's DrawText
+    constexpr int defaultFontSize = 10;
+    if (fontSize < defaultFontSize)
+    {
+        fontSize = defaultFontSize;
+    }
+    const float spacing = static_cast<float>(fontSize / defaultFontSize);
+
+    // From here on, the same as DrawTextEx + DrawTextCodepoint
+    const float scaleFactor = static_cast<float>(fontSize) / static_cast<float>(font.baseSize);
+    const float padding = static_cast<float>(font.glyphPadding);
+    const float texWidth = static_cast<float>(font.texture.width);
+    const float texHeight = static_cast<float>(font.texture.height);
+
+    float offsetX = 0;
+    float offsetY = 0;
+
+    // NOTE: GetCodepointNext can look up to 3 bytes ahead on invalid UTF-8, so `text` should be null terminated (as
+    // interned strings are)
+    size_t i = 0;
+    while (i < text.size())
+    {
+        int codepointByteCount = 0;
+        int codepoint = GetCodepointNext(&text[i], &codepointByteCount);
+        i += codepointByteCount;
+
+        if (codepoint == '\n')
+        {
+            offsetY += static_cast<float>(fontSize + lineSpacing);
+            offsetX = 0;
+            continue;
+        }
+
+        int index = GetGlyphIndex(font, codepoint);
+        const Rectangle& rec = font.recs[index];
+        const GlyphInfo& glyph = font.glyphs[index];
+
+        if ((codepoint != ' ') && (codepoint != '\t'))
+        {
+            GlyphQuad& quad = out.emplace_back();
+            quad.X0 = offsetX + (static_cast<float>(glyph.offsetX) - padding) * scaleFactor;
+            quad.Y0 = offsetY + (static_cast<float>(glyph.offsetY) - padding) * scaleFactor;
+            quad.X1 = quad.X0 + (rec.width + 2.0f * padding) * scaleFactor;
+            quad.Y1 = quad.Y0 + (rec.height + 2.0f * padding) * scaleFactor;
+            quad.U0 = (rec.x - padding) / texWidth;
+            quad.V0 = (rec.y - padding) / texHeight;
+            quad.U1 = (rec.x + rec.width + padding) / texWidth;
+            quad.V1 = (rec.y + rec.height + padding) / texHeight;
+        }
+
+        if (glyph.advanceX == 0)
+        {
+            offsetX += rec.width * scaleFactor + spacing;
+        }
+        else
+        {
+            offsetX += static_cast<float>(glyph.advanceX) * scaleFactor + spacing;
+        }
+    }
+}
+
+void TextLayoutCache::Draw(const Font& font, const GlyphQuad* quads, size_t count, float x, float y, Color tint)
+{
+    rlSetTexture(font.texture.id);
+    RenderBatch::Reserve(static_cast<int>(count * 4));
+    rlBegin(RL_QUADS);
+        rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+        for (size_t i = 0; i < count; i++)
+        {
+            const GlyphQuad& q = quads[i];
+            // Same vertex order as DrawTexturePro
+            rlTexCoord2f(q.U0, q.V0);
+            rlVertex2f(x + q.X0, y + q.Y0);
+            rlTexCoord2f(q.U0, q.V1);
+            rlVertex2f(x + q.X0, y + q.Y1);
+            rlTexCoord2f(q.U1, q.V1);
+            rlVertex2f(x + q.X1, y + q.Y1);
+            rlTexCoord2f(q.U1, q.V0);
+            rlVertex2f(x + q.X1, y + q.Y0);
+        }
+    rlEnd();
+    rlSetTexture(0);
+}
@@ -0,0 +1,125 @@
+/*******************************************************************************************
+*
+*   Batches UI rectangles, text and sprites into one vertex buffer per texture.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "UIBatcher.h"
+#include "RenderBatch.h"
+#include "rlgl.h"
+
+#include <algorithm>
+
+UIBatcher::Batch& UIBatcher::GetBatch(unsigned int textureId)
+{
+    for (size_t i = 0; i < NumBatches; i++)
+    {
+        if (Batches[i].TextureId == textureId)
+        {
+            return Batches[i];
+        }
+    }
+
+    if (NumBatches == Batches.size())
+    {
+        Batches.emplace_back();
+    }
+
+    Batch& batch = Batches[NumBatches++];
+    batch.TextureId = textureId;
+    return batch;
+}
+
+void UIBatcher::AddRect(float x, float y, float width, float height, Color color)
+{
+    // Same as raylib's shapes, which use the default (1x1 white) texture
+    AddQuad(GetBatch(rlGetTextureIdDefault()), x, y, x + width, y + height, 0, 0, 1, 1, color);
+}
+
+void UIBatcher::AddSprite(const Texture2D& texture, Rectangle source, Rectangle dest, Color tint)
+{
+    const float width = static_cast<float>(texture.width);
+    const float height = static_cast<float>(texture.height);
+    AddQuad(
+        GetBatch(texture.id), dest.x, dest.y, dest.x + dest.width, dest.y + dest.height, source.x / width, source.y / height,
+        (source.x + source.width) / width, (source.y + source.height) / height, tint);
+}
+
+void UIBatcher::AddGlyphs(const Font& font, const GlyphQuad* quads, size_t count, float x, float y, Color color)
+{
+    Batch& batch = GetBatch(font.texture.id);
+    for (size_t i = 0; i < count; i++)
+    {
+        const GlyphQuad& q = quads[i];
+        AddQuad(batch, x + q.X0, y + q.Y0, x + q.X1, y + q.Y1, q.U0, q.V0, q.U1, q.V1, color);
+    }
+}
+
+void UIBatcher::AddText(const Font& font, std::string_view text, float x, float y, int fontSize, Color color)
+{
+    Glyphs.clear();
+    TextLayoutCache::Layout(font, text, fontSize, Glyphs);
+    AddGlyphs(font, Glyphs.data(), Glyphs.size(), x, y, color);
+}
+
+void UIBatcher::Submit(RenderCmdQueue& q)
+{
+    for (size_t i = 0; i < NumBatches; i++)
+    {
+        Batch& batch = Batches[i];
+        if (batch.Vertices.empty())
+        {
+            continue;
+        }
+
+        uint32_t count = static_cast<uint32_t>(batch.Vertices.size());
+        RenderCmdQueue::Ref ref = q.OobPush(batch.Vertices.data(), batch.Vertices.size());
+        batch.Vertices.clear();
+        if (!ref.IsSet())
+        {
+            // The queue ran out of memory
+            continue;
+        }
+
+        q.Push([textureId = batch.TextureId, ref, count](RenderCmdQueue& q)
+        {
+            Draw(textureId, &q.OobAtAs<Vertex>(ref), count);
+        });
+
+        CurrStats.NumBatches++;
+        CurrStats.NumVertices += count;
+        CurrStats.NumBytes += count * static_cast<uint32_t>(sizeof(Vertex));
+    }
+
+    NumBatches = 0;
+}
+
+void UIBatcher::Draw(unsigned int textureId, const Vertex* vertices, uint32_t count)
+{
+    // All the vertices share the texture and mode, so rlgl keeps them in a single draw call (unless the batch fills up)
+    rlSetTexture(textureId);
+    while (count)
+    {
+        // Multiple of 4, so we never split a quad
+        uint32_t todo = std::min(count, 1200u);
+        RenderBatch::Reserve(static_cast<int>(todo));
+        rlBegin(RL_QUADS);
+            for (uint32_t i = 0; i < todo; i++)
+            {
+                const Vertex& v = vertices[i];
+                rlColor4ub(v.Col.r, v.Col.g, v.Col.b, v.Col.a);
+                rlTexCoord2f(v.U, v.V);
+                rlVertex2f(v.X, v.Y);
+            }
+        rlEnd();
+
+        vertices += todo;
+        count -= todo;
+    }
+    rlSetTexture(0);
+}
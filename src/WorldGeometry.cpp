@@ -0,0 +1,126 @@
+/*******************************************************************************************
+*
+*   CPU side generation of world geometry.
+*
+*   This example has been created using raylib 5.5 (www.raylib.com)
+*   raylib is licensed under an unmodified zlib/libpng license (View raylib.h for details)
+*
+*   Copyright (c) 2025 Rui Figueira (https://github.com/ruifig)
+*
+********************************************************************************************/
+
+#include "WorldGeometry.h"
+#include "RenderBatch.h"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //
+    // Corner `i` has the sign of x/y/z given by bits 0/1/2
+    //
+
+    // Faces, with the corners in counter clockwise order when seen from outside, since raylib culls back faces.
+    constexpr uint8_t Faces[6][4] = {
+        {4, 5, 7, 6},  // +Z
+        {1, 0, 2, 3},  // -Z
+        {5, 1, 3, 7},  // +X
+        {0, 4, 6, 2},  // -X
+        {6, 7, 3, 2},  // +Y
+        {0, 1, 5, 4},  // -Y
+    };
+
+    constexpr uint8_t Edges[12][2] = {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},  // Along X
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},  // Along Y
+        {0, 4}, {1, 5}, {2, 6}, {3, 7},  // Along Z
+    };
+
+    // Number of vertices we feed rlgl at a time. Multiple of 2 and 3, so it never splits a primitive.
+    constexpr uint32_t DrawChunkVertices = 1200;
+
+}  // namespace
+
+void WorldGeometry::GenerateCube(const CubeDesc& cube, ColorVertex* triangles, ColorVertex* lines)
+{
+    // Rotation matrix for the axis/angle (same as raymath's MatrixRotate)
+    float x = cube.RotationAxis.x, y = cube.RotationAxis.y, z = cube.RotationAxis.z;
+    float lengthSqr = x * x + y * y + z * z;
+    if ((lengthSqr != 1.0f) && (lengthSqr != 0.0f))
+    {
+        float ilength = 1.0f / std::sqrt(lengthSqr);
+        x *= ilength;
+        y *= ilength;
+        z *= ilength;
+    }
+
+    const float angle = cube.Degrees * DEG2RAD;
+    const float s = std::sin(angle);
+    const float c = std::cos(angle);
+    const float t = 1.0f - c;
+
+    const float r[3][3] = {
+        {x * x * t + c, x * y * t - z * s, x * z * t + y * s},
+        {y * x * t + z * s, y * y * t + c, y * z * t - x * s},
+        {z * x * t - y * s, z * y * t + x * s, z * z * t + c},
+    };
+
+    // Only 8 unique positions, so we transform those, and the rest is just copying
+    const float hx = cube.Width / 2, hy = cube.Height / 2, hz = cube.Length / 2;
+    Vector3 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        const float lx = (i & 1) ? hx : -hx;
+        const float ly = (i & 2) ? hy : -hy;
+        const float lz = (i & 4) ? hz : -hz;
+        corners[i].x = cube.Position.x + r[0][0] * lx + r[0][1] * ly + r[0][2] * lz;
+        corners[i].y = cube.Position.y + r[1][0] * lx + r[1][1] * ly + r[1][2] * lz;
+        corners[i].z = cube.Position.z + r[2][0] * lx + r[2][1] * ly + r[2][2] * lz;
+    }
+
+    auto put = [](ColorVertex*& out, const Vector3& pos, Color col)
+    {
+        *out++ = {pos.x, pos.y, pos.z, col};
+    };
+
+    for (const uint8_t* face : Faces)
+    {
+        // Two triangles per face: (a,b,d) and (c,d,b)
+        put(triangles, corners[face[0]], cube.CubeColor);
+        put(triangles, corners[face[1]], cube.CubeColor);
+        put(triangles, corners[face[3]], cube.CubeColor);
+        put(triangles, corners[face[2]], cube.CubeColor);
+        put(triangles, corners[face[3]], cube.CubeColor);
+        put(triangles, corners[face[1]], cube.CubeColor);
+    }
+
+    for (const uint8_t* edge : Edges)
+    {
+        put(lines, corners[edge[0]], cube.WireColor);
+        put(lines, corners[edge[1]], cube.WireColor);
+    }
+}
+
+void WorldGeometry::Draw(int mode, const ColorVertex* vertices, uint32_t count)
+{
+    while (count)
+    {
+        uint32_t todo = std::min(count, DrawChunkVertices);
+
+        // Flushes rlgl's batch beforehand if the chunk doesn't fit
+        RenderBatch::Reserve(static_cast<int>(todo));
+        rlBegin(mode);
+            for (uint32_t i = 0; i < todo; i++)
+            {
+                const ColorVertex& v = vertices[i];
+                rlColor4ub(v.Col.r, v.Col.g, v.Col.b, v.Col.a);
+                rlVertex3f(v.X, v.Y, v.Z);
+            }
+        rlEnd();
+
+        vertices += todo;
+        count -= todo;
+    }
+}
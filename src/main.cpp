@@ -31,7 +31,9 @@
 #include "Common.h"
 #include "FrameThread.h"
 #include "RenderQueue.h"
+#include "RenderPasses.h"
 #include "FPSCalculator.h"
+#include "WorkerPool.h"
 #include "raylib.h"
 #include "raymath.h"
 #include "rlgl.h"
@@ -40,6 +42,7 @@
 #include <atomic>
 #include <chrono>
 #include <algorithm>
+#include <memory_resource>
 #include <random>
 
 using namespace std::literals::chrono_literals;
@@ -62,7 +65,6 @@ using namespace std::literals::chrono_literals;
     #error This sample requires Raylib to be compiled with SUPPORT_CUSTOM_FRAME_CONTROL
 #endif
 
-Camera3D camera = {};
 
 FrameThreadControl thControl(NUM_THREADS);
 
@@ -87,6 +89,10 @@ protected:
 
 PhysicsThread physicsTh(thControl);
 float renderAvgWorkTimeMs = 0;
+// Render time budget, toggled with B. Changed by the main thread only while the other threads are waiting.
+float renderBudgetMs = 0;
+// Queue capacities saved at shutdown, and used to size the queues at startup
+constexpr const char* QueueProfileFile = "queue_profile.txt";
 
 //
 // Thread for the gameplay logic.
@@ -96,6 +102,7 @@ class GameLogicThread : public FrameThread
 public:
     GameLogicThread(FrameThreadControl& control)
         : FrameThread(control, "GameLogic")
+        , Workers(NumWorkers)
         , Rdgen(std::random_device()())
     {
     }
@@ -144,32 +151,254 @@ protected:
         }
     }
 
+    //
+    // The World group is rendered with the main camera, and optionally a top-down minimap in the top right corner.
+    // Both views replay the same recorded commands.
+    //
+    void UpdateViews()
+    {
+        constexpr float minimapSize = 300;
+        RenderView views[2];
+        views[0].Camera = Camera;
+        views[1].Camera.position = {0.0f, 700.0f, -210.0f};
+        views[1].Camera.target = {0.0f, 0.0f, -210.0f};
+        views[1].Camera.up = {0.0f, 0.0f, -1.0f};
+        views[1].Camera.fovy = 600.0f;
+        views[1].Camera.projection = CAMERA_ORTHOGRAPHIC;
+        views[1].Viewport = {static_cast<float>(GetRenderWidth()) - minimapSize - 10, 10, minimapSize, minimapSize};
+        views[1].Clear = true;
+        views[1].ClearColor = {48, 48, 48, 255};
+
+        RenderQueue::SetViews(RenderGroup::World, std::span<const RenderView>(views, ShowMinimap ? 2 : 1));
+    }
+
+    // Returns true if the cube is inside the frustum of any of the World's views
+    static bool IsCubeVisible(const Vector3& position, float radius)
+    {
+        for (size_t i = 0; i < RenderQueue::GetNumViews(RenderGroup::World); i++)
+        {
+            if (RenderQueue::GetCamera(RenderGroup::World, i).ViewFrustum.IsSphereVisible(position, radius))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void OnStart()
     {
         AddCube(5000);
+
+        Camera.position = {0.0f, 0.0f, 100.0f};  // Camera position
+        Camera.target = {0.0f, 0.0f, 0.0f};       // Camera looking at point
+        Camera.up = {0.0f, 1.0f, 0.0f};           // Camera up vector (rotation towards target)
+        Camera.fovy = 45.0f;                      // Camera field-of-view Y
+        Camera.projection = CAMERA_PERSPECTIVE;   // Camera projection type
+
+        // The panel background and help text never change, so we record them once, and just execute the block each frame.
+        // The help text is interned, so the block holds the already laid out glyphs.
+        StaticUI = RenderQueue::RecordBlock([]()
+        {
+            RenderQueue::DrawRectangle(0, 0, FontSize * 62, 13 * FontSize, {32, 32, 32, 200});
+            RenderQueue::DrawText(
+                RenderQueue::Intern("Press [ or ] change the number of cubes, M toggles the minimap, B toggles the render budget, R cycles how cubes are queued"), 0, 12 * FontSize,
+                FontSize, BROWN);
+        });
+    }
+
+    void OnEnd() override
+    {
+        // The block's commands may own memory from the RenderQueue's allocators, so it can't outlive them
+        StaticUI.reset();
     }
 
     void Update() override
     {
         FpsCalc.Tick(Control.DeltaSeconds);
 
-        // Process the cubes
-        for(Cube& cube : Cubes)
+        // The camera is owned by this thread, and published as a snapshot for each view, which is what the render thread
+        // renders with, and what the workers cull against.
+        UpdateCamera(&Camera, CAMERA_PERSPECTIVE);
+        if (IsKeyPressed(KEY_M))
+        {
+            ShowMinimap = !ShowMinimap;
+        }
+        if (IsKeyPressed(KEY_R))
+        {
+            Mode = static_cast<CubeMode>((static_cast<int>(Mode) + 1) % static_cast<int>(CubeMode::Count));
+        }
+        UpdateViews();
+
+        // Vertex generation stats for the previous frame. Throughput is per core, since it's divided by the sum of the time
+        // each worker spent generating.
+        const uint64_t genVertices = GenVertices.exchange(0);
+        const uint64_t genNs = GenNs.exchange(0);
+        const uint64_t culledCubes = CulledCubes.exchange(0);
+        const double genThroughput = genNs ? (static_cast<double>(genVertices) * 1000.0 / static_cast<double>(genNs)) : 0.0;
+
+        // Process the cubes.
+        // The cubes are split into chunks, and each chunk is recorded into its own secondary command buffer by the workers.
+        // The secondaries are requested here in order, so the draw order is still deterministic.
+        // Half the chunks are less important, so if the render thread is over budget, it drops those first and the World
+        // is decimated instead of disappearing.
+        RenderCmdBlock* chunks[NumChunks];
+        for (int i = 0; i < NumChunks; i++)
+        {
+            RenderQueue::ImportanceScope importance(i % 2 ? RenderImportance::Low : RenderImportance::Normal);
+            chunks[i] = &RenderQueue::ExecuteSecondary(RenderGroup::World);
+        }
+
+        const int chunkSize = (static_cast<int>(Cubes.size()) + NumChunks - 1) / NumChunks;
+
+        // Per chunk list of cubes that are visible, from the frame arena. The workers can't use the arena, so the lists are
+        // reserved here, and the workers only fill them.
+        std::pmr::vector<std::pmr::vector<int>> visibleCubes(NumChunks, &Arena);
+        for (std::pmr::vector<int>& visible : visibleCubes)
         {
-            cube.RotationDegrees += Control.DeltaSeconds * 360 * cube.RotationSpeed;
-            RenderQueue::DrawCubeEx(cube.Position, cube.RotationDegrees, cube.RotationAxis, cube.Width, cube.Height, cube.Height, cube.CubeColor, cube.WireColor);
+            visible.reserve(chunkSize);
         }
 
-        constexpr int fontSize = 20;
+        // With the snapshot, the cubes are published once for the frame, and the chunks only queue ranges of it. It can be
+        // released straight away, since it isn't reused until the render thread is done with this frame.
+        CubeSnapshot* snapshot = nullptr;
+        if (Mode == CubeMode::Snapshot)
+        {
+            snapshot = &RenderQueue::AcquireCubeSnapshot();
+            for (Cube& cube : Cubes)
+            {
+                cube.RotationDegrees += Control.DeltaSeconds * 360 * cube.RotationSpeed;
+                snapshot->Add(ToCubeDesc(cube));
+            }
+            snapshot->Publish();
+        }
+        Workers.ParallelFor(NumChunks, [&](int index)
+        {
+            RenderQueue::Record(*chunks[index], [&]()
+            {
+                const int begin = std::min(static_cast<int>(Cubes.size()), index * chunkSize);
+                const int end = std::min(static_cast<int>(Cubes.size()), (index + 1) * chunkSize);
+                std::pmr::vector<int>& visible = visibleCubes[index];
+                for (int i = begin; i < end; i++)
+                {
+                    Cube& cube = Cubes[i];
+                    if (!snapshot)
+                    {
+                        cube.RotationDegrees += Control.DeltaSeconds * 360 * cube.RotationSpeed;
+                    }
+
+                    // Cubes no view can see are not generated at all
+                    if (IsCubeVisible(cube.Position, std::sqrt(cube.Width * cube.Width + 2 * cube.Height * cube.Height) / 2))
+                    {
+                        // Growing would allocate from the arena, which isn't thread safe
+                        assert(visible.size() < visible.capacity());
+                        visible.push_back(i);
+                    }
+                }
+                CulledCubes += (end - begin) - visible.size();
+
+                // Queued by this thread once all the chunks are culled
+                if (Mode == CubeMode::Columns)
+                {
+                    return;
+                }
+
+                if (snapshot)
+                {
+                    // One command per run of visible cubes
+                    size_t runStart = 0;
+                    for (size_t j = 0; j < visible.size(); j++)
+                    {
+                        if (j + 1 == visible.size() || visible[j + 1] != visible[j] + 1)
+                        {
+                            RenderQueue::DrawCubeRange(*snapshot, visible[runStart], visible[j] + 1);
+                            runStart = j + 1;
+                        }
+                    }
+                    return;
+                }
+
+                // The workers generate the final vertices, so the render thread doesn't have to
+                auto start = std::chrono::high_resolution_clock::now();
+                RenderQueue::DrawCubesEx(static_cast<uint32_t>(visible.size()), [&](uint32_t i)
+                {
+                    return ToCubeDesc(Cubes[visible[i]]);
+                });
+                GenNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+                GenVertices += visible.size() * (WorldGeometry::CubeTriangleVertices + WorldGeometry::CubeLineVertices);
+            });
+        });
+
+        if (snapshot)
+        {
+            RenderQueue::ReleaseCubeSnapshot(*snapshot);
+        }
+
+        // DrawCubeEx only pushes to the World group's columns when not recording, so the visible cubes are queued here, in
+        // chunk order. The render thread decodes the columns, but still draws each cube with rlgl.
+        if (Mode == CubeMode::Columns)
+        {
+            for (const std::pmr::vector<int>& visible : visibleCubes)
+            {
+                for (int i : visible)
+                {
+                    const Cube& cube = Cubes[i];
+                    RenderQueue::DrawCubeEx(
+                        cube.Position, cube.RotationDegrees, cube.RotationAxis, cube.Width, cube.Height, cube.Height, cube.CubeColor, cube.WireColor);
+                }
+            }
+        }
+
+        constexpr int fontSize = FontSize;
         auto Line = [&](int l) { return l * fontSize; };
 
-        RenderQueue::DrawRectangle(0, 0, fontSize * 30, 6 * fontSize, {32, 32, 32, 200});
-        RenderQueue::DrawText(TextFormat("FPS: %d", FpsCalc.GetFps()), 0, Line(0), fontSize, RED);
-        RenderQueue::DrawText(TextFormat("GameLogic frametime: %4.2f ms", GetAvgWorkTimeMs()), 0, Line(1), fontSize, RED);
-        RenderQueue::DrawText(TextFormat("Physics frametime: %4.2f ms", physicsTh.GetAvgWorkTimeMs()), 0, Line(2), fontSize, RED);
-        RenderQueue::DrawText(TextFormat("Render frametime: %4.2f ms", renderAvgWorkTimeMs), 0, Line(3), fontSize, RED);
-        RenderQueue::DrawText(TextFormat("Number of cubes: %d", static_cast<int>(Cubes.size())), 0, Line(4), fontSize, RED);
-        RenderQueue::DrawText("Press [ or ] change the number of cubes", 0, Line(5), 20, BROWN);
+        RenderQueue::ExecuteBlock(RenderGroup::UI, StaticUI);
+        // The dynamic text is laid out here and batched, so the render thread only draws one vertex buffer
+        UIBatcher::Stats batcherStats = UI.GetStats();
+        UI.ResetStats();
+        const Font& font = RenderQueue::GetFont(0);
+        UI.AddTextF(font, 0, Line(0), fontSize, RED, "FPS: {}", FpsCalc.GetFps());
+        UI.AddTextF(font, 0, Line(1), fontSize, RED, "GameLogic frametime: {:4.2f} ms", GetAvgWorkTimeMs());
+        UI.AddTextF(font, 0, Line(2), fontSize, RED, "Physics frametime: {:4.2f} ms", physicsTh.GetAvgWorkTimeMs());
+        UI.AddTextF(font, 0, Line(3), fontSize, RED, "Render frametime: {:4.2f} ms", renderAvgWorkTimeMs);
+        UI.AddTextF(font, 0, Line(5), fontSize, RED, "UI batches: {}, vertices: {}, bytes: {}", batcherStats.NumBatches, batcherStats.NumVertices, batcherStats.NumBytes);
+        UI.AddTextF(
+            font, 0, Line(6), fontSize, RED, "World vertices: {}, generated at {:.1f} M/s per core, {} cubes culled, queued as {}", genVertices, genThroughput,
+            culledCubes, CubeModeNames[static_cast<int>(Mode)]);
+        const RenderGroupStats& worldStats = RenderQueue::GetGroupStats(RenderGroup::World);
+        const RenderGroupStats& uiStats = RenderQueue::GetGroupStats(RenderGroup::UI);
+        UI.AddTextF(
+            font, 0, Line(7), fontSize, RED, "World: {:4.2f} ms, {} flushes ({} verts cap), {} views, {} culled. UI: {:4.2f} ms, {} flushes",
+            worldStats.RenderMs, worldStats.Batch.Flushes, worldStats.Batch.Capacity, worldStats.NumViews, worldStats.NumCulled, uiStats.RenderMs,
+            uiStats.Batch.Flushes);
+        UI.AddTextF(
+            font, 0, Line(8), fontSize, RED, "Render budget: {:.1f} ms (0 is off), drop level {}, dropped: World {}, UI {}", renderBudgetMs,
+            RenderQueue::GetDropLevel(), worldStats.NumDropped, uiStats.NumDropped);
+        const RenderMemoryStats& memStats = RenderQueue::GetMemoryStats();
+        UI.AddTextF(
+            font, 0, Line(9), fontSize, RED, "Queue memory: {:.2f} MB, {:.2f} MB written, failed pushes: {}",
+            static_cast<double>(memStats.Capacity) / (1024 * 1024), static_cast<double>(memStats.UsedBytes) / (1024 * 1024), memStats.NumFailedPushes);
+        UI.AddTextF(
+            font, 0, Line(10), fontSize, RED, "Frame arena: {:.1f} KB high water, {:.1f} KB capacity, {} overflows",
+            static_cast<double>(Arena.GetHighWater()) / 1024, static_cast<double>(Arena.GetCapacity()) / 1024, Arena.GetNumOverflows());
+        for (size_t i = 0; i < RenderQueue::GetNumPasses(); i++)
+        {
+            const RenderPassStats& passStats = RenderQueue::GetPassStats(i);
+            UI.AddTextF(
+                font, 0, Line(11 + static_cast<int>(i)), fontSize, RED, "Pass {}: {:.3f} ms, {} groups, {} dropped", RenderQueue::GetPass(i).GetName(),
+                passStats.Ms, passStats.NumGroups, passStats.NumDropped);
+        }
+        RenderQueue::DrawBatch(UI);
+
+        // The number of cubes rarely changes, so we keep the text in the persistent arena, and only recreate it when needed
+        if (CubesLabelCount != Cubes.size())
+        {
+            RenderQueue::GetArena().Release(CubesLabel);
+            char buf[64];
+            auto res = std::format_to_n(buf, sizeof(buf), "Number of cubes: {}", Cubes.size());
+            CubesLabel = RenderQueue::GetArena().PushString(std::string_view(buf, res.out), PersistentArena::Lifetime::UntilReleased());
+            CubesLabelCount = Cubes.size();
+        }
+        RenderQueue::DrawText(CubesLabel, 0, Line(4), fontSize, RED);
 
         constexpr int numCubes = 100;
         if (IsKeyPressed(KEY_LEFT_BRACKET))
@@ -201,6 +430,38 @@ protected:
         Color WireColor;
     };
     std::vector<Cube> Cubes;
+
+    static CubeDesc ToCubeDesc(const Cube& cube)
+    {
+        return {cube.Position, cube.RotationDegrees, cube.RotationAxis, cube.Width, cube.Height, cube.Height, cube.CubeColor, cube.WireColor};
+    }
+
+    static constexpr int NumWorkers = 3;
+    static constexpr int NumChunks = 8;
+    WorkerPool Workers;
+    std::atomic<uint64_t> GenVertices = 0;
+    std::atomic<uint64_t> GenNs = 0;
+    std::atomic<uint64_t> CulledCubes = 0;
+    Camera3D Camera = {};
+    bool ShowMinimap = true;
+    // How the cubes get to the render thread. Cycled with R.
+    enum class CubeMode
+    {
+        // The workers generate the vertices
+        Vertices,
+        // The cubes are published as a CubeSnapshot, and the workers queue ranges of it
+        Snapshot,
+        // The workers only cull, and the visible cubes are queued with DrawCubeEx, which uses the column path
+        Columns,
+        Count
+    };
+    static constexpr const char* CubeModeNames[] = {"vertices", "snapshot", "columns"};
+    CubeMode Mode = CubeMode::Vertices;
+    static constexpr int FontSize = 20;
+    std::shared_ptr<RenderCmdBlock> StaticUI;
+    UIBatcher UI;
+    PersistentArena::Ref CubesLabel;
+    size_t CubesLabelCount = std::numeric_limits<size_t>::max();
     FPSCalculator<> FpsCalc;
     std::mt19937 Rdgen;
 };
@@ -217,13 +478,33 @@ int main(int argc, char* argv[])
     SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_WINDOW_RESIZABLE /* | FLAG_VSYNC_HINT */);
     InitWindow(screenWidth, screenHeight, "raylibExtras SeparateThreads example");
 
-    camera.position = {0.0f, 0.0f, 100.0f};  // Camera position
-    camera.target = {0.0f, 0.0f, 0.0f};       // Camera looking at point
-    camera.up = {0.0f, 1.0f, 0.0f};           // Camera up vector (rotation towards target)
-    camera.fovy = 45.0f;                      // Camera field-of-view Y
-    camera.projection = CAMERA_PERSPECTIVE;   // Camera projection type
+    // Secondaries come and go with the number of chunks, so they share a pool to reuse each other's memory, while the
+    // World group's queue, which is the biggest, grows in place without copying.
+    // Declared before the RenderQueue, so they outlive it.
+    PagePoolQueueAllocator queuePool;
+    VirtualMemoryQueueAllocator worldQueueMemory(256 * 1024 * 1024);
 
     RenderQueue renderQueue;
+    renderQueue.SetQueueAllocator(&queuePool);
+    {
+        RenderGroupDesc worldDesc = RenderQueue::GetGroupDesc(RenderGroup::World);
+        worldDesc.Allocator = &worldQueueMemory;
+        renderQueue.SetGroupDesc(RenderGroup::World, worldDesc);
+    }
+    // Fonts are registered before the other threads start, so they can lay out text
+    renderQueue.AddFont(GetFontDefault());
+    // Keeps the memory used by each frame's queues bounded, no matter how many cubes are added
+    renderQueue.SetMemoryBudget(256 * 1024 * 1024, 64 * 1024 * 1024);
+    // Quantize command data where supported, to reduce how much goes from the logic threads to the render thread. In this
+    // sample, that's the DrawCubeEx columns, used when the cubes are queued as columns (see the R key).
+    renderQueue.SetCompactCommands(true);
+    // Commands no view can see are dropped once, by the pass workers, instead of once per view by the render thread.
+    // Here, those are the chunks' secondaries when the workers generate the vertices (the other cube modes don't have
+    // bounds). The cubes are scattered at random, so a chunk is rarely out of every view (the minimap sees almost all of
+    // them), and the overlay mostly shows what the pass costs.
+    renderQueue.AddPass(std::make_unique<CullRenderPass>());
+    // Size the queues from what the last run needed, so the first frames don't spend time growing them
+    renderQueue.LoadQueueProfile(QueueProfileFile);
     // Abusing the FPSCalculator to calculate how long the rendering takes.
     FPSCalculator renderWorkCalc;
 
@@ -277,6 +558,11 @@ int main(int argc, char* argv[])
         {
             RenderQueue::Get().SwapQueues();
             PollInputEvents();
+            if (IsKeyPressed(KEY_B))
+            {
+                renderBudgetMs = renderBudgetMs > 0 ? 0 : 8.0f;
+                renderQueue.SetRenderBudget(renderBudgetMs);
+            }
             ++frameNum;
             auto now = std::chrono::high_resolution_clock::now();
             thControl.DeltaSeconds = std::chrono::duration<float>(now - thControl.FrameStartTime).count();
@@ -286,6 +572,11 @@ int main(int argc, char* argv[])
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
+    // The threads still hold render resources (e.g: recorded blocks), which need to be released before the RenderQueue
+    gameLogicTh.Join();
+    physicsTh.Join();
+    renderQueue.SaveQueueProfile(QueueProfileFile);
+    renderQueue.Unload();
     CloseWindow();  // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 